@@ -0,0 +1,53 @@
+/*
+ * Common definitions of the libm functions that use the VFP instructions
+ * of the ARMv7E-M multilibs (FPv4-SP and FPv5) instead of newlib's generic
+ * C code. For multilibs without the instructions a function compiles to
+ * nothing and newlib's own is kept.
+ */
+
+#ifndef FPUMATH_H
+#define FPUMATH_H
+
+#if defined(__ARM_FP) && (__ARM_FP & 4)
+#define FPUMATH_SP 1
+#else
+#define FPUMATH_SP 0
+#endif
+
+#if defined(__ARM_FP) && (__ARM_FP & 8)
+#define FPUMATH_DP 1
+#else
+#define FPUMATH_DP 0
+#endif
+
+/*
+ * FPv5 adds VRINT, VMINNM and VMAXNM. GCC has no macro for it on M-profile,
+ * so the recipe defines FPUMATH_FPV5 for the fpv5 multilibs.
+ */
+#if FPUMATH_SP && defined(FPUMATH_FPV5)
+#define FPUMATH_V5 1
+#else
+#define FPUMATH_V5 0
+#endif
+
+/* One VFP instruction on a float, "t" is a single precision register */
+#define VFP_F32(insn, x) ({ \
+	float __r; \
+	__asm__ (insn ".f32 %0, %1" : "=t" (__r) : "t" (x)); \
+	__r; \
+})
+
+#define VFP2_F32(insn, x, y) ({ \
+	float __r; \
+	__asm__ (insn ".f32 %0, %1, %2" : "=t" (__r) : "t" (x), "t" (y)); \
+	__r; \
+})
+
+/* "w" is a double precision register */
+#define VFP_F64(insn, x) ({ \
+	double __r; \
+	__asm__ (insn ".f64 %P0, %P1" : "=w" (__r) : "w" (x)); \
+	__r; \
+})
+
+#endif /* FPUMATH_H */
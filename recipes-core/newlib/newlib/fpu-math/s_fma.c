@@ -0,0 +1,12 @@
+#include <math.h>
+#include "fpumath.h"
+
+#if FPUMATH_DP
+
+double fma(double x, double y, double z)
+{
+	__asm__ ("vfma.f64 %P0, %P1, %P2" : "+w" (z) : "w" (x), "w" (y));
+	return z;
+}
+
+#endif
@@ -0,0 +1,11 @@
+#include <math.h>
+#include "fpumath.h"
+
+#if FPUMATH_SP
+
+float fabsf(float x)
+{
+	return VFP_F32("vabs", x);
+}
+
+#endif
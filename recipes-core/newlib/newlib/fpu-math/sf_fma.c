@@ -0,0 +1,13 @@
+#include <math.h>
+#include "fpumath.h"
+
+#if FPUMATH_SP
+
+float fmaf(float x, float y, float z)
+{
+	/* VFMA accumulates into its destination, rounding only once */
+	__asm__ ("vfma.f32 %0, %1, %2" : "+t" (z) : "t" (x), "t" (y));
+	return z;
+}
+
+#endif
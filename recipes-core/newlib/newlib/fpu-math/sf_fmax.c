@@ -0,0 +1,11 @@
+#include <math.h>
+#include "fpumath.h"
+
+#if FPUMATH_V5
+
+float fmaxf(float x, float y)
+{
+	return VFP2_F32("vmaxnm", x, y);
+}
+
+#endif
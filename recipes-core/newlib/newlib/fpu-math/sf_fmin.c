@@ -0,0 +1,12 @@
+#include <math.h>
+#include "fpumath.h"
+
+#if FPUMATH_V5
+
+float fminf(float x, float y)
+{
+	/* VMINNM returns the number when one operand is a quiet NaN */
+	return VFP2_F32("vminnm", x, y);
+}
+
+#endif
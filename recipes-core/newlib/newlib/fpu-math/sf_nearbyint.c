@@ -0,0 +1,12 @@
+#include <math.h>
+#include "fpumath.h"
+
+#if FPUMATH_V5
+
+float nearbyintf(float x)
+{
+	/* Like rintf, but without raising inexact */
+	return VFP_F32("vrintr", x);
+}
+
+#endif
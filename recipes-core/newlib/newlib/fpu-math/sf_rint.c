@@ -0,0 +1,12 @@
+#include <math.h>
+#include "fpumath.h"
+
+#if FPUMATH_V5
+
+float rintf(float x)
+{
+	/* Rounds in the current rounding mode and raises inexact */
+	return VFP_F32("vrintx", x);
+}
+
+#endif
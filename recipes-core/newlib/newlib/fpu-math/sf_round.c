@@ -0,0 +1,11 @@
+#include <math.h>
+#include "fpumath.h"
+
+#if FPUMATH_V5
+
+float roundf(float x)
+{
+	return VFP_F32("vrinta", x);
+}
+
+#endif
@@ -0,0 +1,15 @@
+#include <math.h>
+#include <errno.h>
+#include "fpumath.h"
+
+#if FPUMATH_DP
+
+double sqrt(double x)
+{
+	if (x < 0.0) {
+		errno = EDOM;
+	}
+	return VFP_F64("vsqrt", x);
+}
+
+#endif
@@ -0,0 +1,35 @@
+#include <math.h>
+#include <errno.h>
+#include "fpumath.h"
+
+#if FPUMATH_SP
+
+float __ieee754_hypotf(float x, float y);
+
+float hypotf(float x, float y)
+{
+	float ax = VFP_F32("vabs", x);
+	float ay = VFP_F32("vabs", y);
+	float r;
+
+	/*
+	 * Where the squares can neither overflow nor lose precision to
+	 * underflow, one fused multiply-add and VSQRT are within an ulp. The
+	 * rest, infinities and NaNs included, goes the scaling way of newlib.
+	 */
+	if (ax < 0x1p60f && ay < 0x1p60f && (ax > 0x1p-60f || ay > 0x1p-60f)) {
+		__asm__ ("vmul.f32 %0, %1, %1\n\t"
+			 "vfma.f32 %0, %2, %2\n\t"
+			 "vsqrt.f32 %0, %0"
+			 : "=&t" (r) : "t" (ay), "t" (ax));
+		return r;
+	}
+
+	r = __ieee754_hypotf(x, y);
+	if (isinf(r) && isfinite(x) && isfinite(y)) {
+		errno = ERANGE;
+	}
+	return r;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#include <math.h>
+#include <errno.h>
+#include "fpumath.h"
+
+#if FPUMATH_SP
+
+float sqrtf(float x)
+{
+	/* VSQRT returns the default NaN, only errno is left to set */
+	if (x < 0.0f) {
+		errno = EDOM;
+	}
+	return VFP_F32("vsqrt", x);
+}
+
+#endif
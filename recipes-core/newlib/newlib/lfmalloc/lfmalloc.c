@@ -0,0 +1,492 @@
+/*
+ * lfmalloc, a malloc for SMP targets linked with -specs=lfmalloc.specs in
+ * place of the newlib one.
+ *
+ * Blocks of up to 2 KiB come from per-CPU free lists, one per size class,
+ * that only their CPU touches. A block freed on another CPU is pushed onto
+ * a lock-free stack of its owner, which takes the whole stack back with a
+ * single atomic exchange once its own list runs empty, so neither path
+ * takes a lock. Larger blocks and new memory from sbrk are handled under a
+ * short spinlock.
+ *
+ * The application tells lfmalloc which CPU it runs on by defining
+ *
+ *   int __lfmalloc_cpu_enter(unsigned int *key);
+ *   void __lfmalloc_cpu_exit(unsigned int key);
+ *
+ * where enter returns the current CPU (below LFMALLOC_MAX_CPUS) and keeps
+ * the caller on it until exit, i.e. with irq_lock() on Zephyr. The default
+ * ones serialize everything through __malloc_lock() on CPU 0, like the
+ * newlib malloc.
+ *
+ * Multilibs without an atomic compare-and-swap get an empty library, and
+ * so the newlib malloc. mallinfo() and malloc_stats() are not supported.
+ */
+
+#include <errno.h>
+#include <reent.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+
+#ifndef LFMALLOC_MAX_CPUS
+#define LFMALLOC_MAX_CPUS	8
+#endif
+
+/* Memory taken from sbrk at once to refill a size class */
+#ifndef LFMALLOC_REFILL
+#define LFMALLOC_REFILL		2048
+#endif
+
+#define ALIGNMENT		8
+#define KIND_LARGE		0xfffe
+#define KIND_ALIGNED		0xfffd
+
+/* Precedes every block, and keeps the payload 8-byte aligned */
+struct header {
+	uint32_t size;		/* payload size, offset for KIND_ALIGNED */
+	uint16_t cpu;		/* CPU whose cache the block belongs to */
+	uint16_t kind;		/* size class or KIND_* */
+};
+
+/* A free block, the link overlays the payload */
+struct block {
+	struct block *next;
+};
+
+static const uint32_t class_size[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048
+};
+
+#define NCLASSES	(sizeof(class_size) / sizeof(class_size[0]))
+#define MAX_SMALL	2048
+
+struct cpu_cache {
+	struct block *local[NCLASSES];
+	struct block *remote[NCLASSES];
+} __attribute__((aligned(64)));
+
+static struct cpu_cache caches[LFMALLOC_MAX_CPUS];
+
+/* Free large blocks, binned by the power of two below their size */
+#define LARGE_BINS	20
+
+/* Protects sbrk and the large block bins */
+static int core_lock;
+static struct block *large_free[LARGE_BINS];
+
+extern void __malloc_lock(struct _reent *r);
+extern void __malloc_unlock(struct _reent *r);
+
+/*
+ * The reent of the calling thread with the reent variant of newlib, whose
+ * reent is per thread. newlib's own __getreent returns _impure_ptr.
+ */
+extern struct _reent *__getreent(void);
+#undef _REENT
+#define _REENT __getreent()
+
+__attribute__((weak)) int __lfmalloc_cpu_enter(unsigned int *key)
+{
+	*key = 0;
+	__malloc_lock(_REENT);
+	return 0;
+}
+
+__attribute__((weak)) void __lfmalloc_cpu_exit(unsigned int key)
+{
+	(void)key;
+	__malloc_unlock(_REENT);
+}
+
+static void spin_lock(int *lock)
+{
+	while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+		while (__atomic_load_n(lock, __ATOMIC_RELAXED)) {
+		}
+	}
+}
+
+static void spin_unlock(int *lock)
+{
+	__atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+static inline struct header *header_of(void *p)
+{
+	return (struct header *)p - 1;
+}
+
+static int size_class(size_t n)
+{
+	unsigned int c;
+
+	for (c = 0; c < NCLASSES; c++) {
+		if (n <= class_size[c]) {
+			return c;
+		}
+	}
+	return -1;
+}
+
+/* Called with core_lock held */
+static char *morecore(struct _reent *r, size_t size)
+{
+	char *p = _sbrk_r(r, size + ALIGNMENT - 1);
+
+	if (p == (char *)-1) {
+		return NULL;
+	}
+	return (char *)(((uintptr_t)p + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1));
+}
+
+static struct block *refill(struct _reent *r, int cpu, int c)
+{
+	size_t bsize = sizeof(struct header) + class_size[c];
+	size_t count = LFMALLOC_REFILL / bsize;
+	struct block *list = NULL;
+	char *chunk;
+
+	if (count < 4) {
+		count = 4;
+	}
+
+	spin_lock(&core_lock);
+	chunk = morecore(r, count * bsize);
+	spin_unlock(&core_lock);
+	if (!chunk) {
+		return NULL;
+	}
+
+	while (count--) {
+		struct header *h = (struct header *)(chunk + count * bsize);
+		struct block *b = (struct block *)(h + 1);
+
+		h->size = class_size[c];
+		h->cpu = cpu;
+		h->kind = c;
+		b->next = list;
+		list = b;
+	}
+	return list;
+}
+
+static void *small_alloc(struct _reent *r, int cpu, int c)
+{
+	struct cpu_cache *cache = &caches[cpu];
+	struct block *b = cache->local[c];
+
+	if (!b) {
+		/* Take back everything other CPUs freed */
+		b = __atomic_exchange_n(&cache->remote[c], NULL,
+					__ATOMIC_ACQUIRE);
+	}
+	if (!b) {
+		b = refill(r, cpu, c);
+		if (!b) {
+			return NULL;
+		}
+	}
+	cache->local[c] = b->next;
+	return b;
+}
+
+static void small_free(int cpu, struct header *h)
+{
+	struct block *b = (struct block *)(h + 1);
+	struct block **remote;
+	struct block *head;
+
+	if (h->cpu == cpu) {
+		b->next = caches[cpu].local[h->kind];
+		caches[cpu].local[h->kind] = b;
+		return;
+	}
+
+	/*
+	 * Push only, the owner takes the whole stack at once, so there is no
+	 * ABA problem
+	 */
+	remote = &caches[h->cpu].remote[h->kind];
+	head = __atomic_load_n(remote, __ATOMIC_RELAXED);
+	do {
+		b->next = head;
+	} while (!__atomic_compare_exchange_n(remote, &head, b, 1,
+					      __ATOMIC_RELEASE,
+					      __ATOMIC_RELAXED));
+}
+
+/* Blocks of a bin looked at before moving on to the next one */
+#define LARGE_SCAN	8
+
+static int large_bin(size_t n)
+{
+	int bin;
+
+	if (n < 2 * MAX_SMALL) {
+		return 0;
+	}
+	bin = 31 - __builtin_clz((unsigned int)(n / MAX_SMALL));
+	return bin < LARGE_BINS ? bin : LARGE_BINS - 1;
+}
+
+/* Called with core_lock held */
+static void large_push(struct header *h)
+{
+	struct block *b = (struct block *)(h + 1);
+	int bin = large_bin(h->size);
+
+	b->next = large_free[bin];
+	large_free[bin] = b;
+}
+
+/*
+ * First fit among the first blocks of the bin of the size and the larger
+ * ones, or new memory
+ */
+static void *large_alloc(struct _reent *r, size_t n)
+{
+	struct block **prev;
+	struct block *b = NULL;
+	struct header *h;
+	int bin;
+	int scan;
+
+	n = (n + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+
+	spin_lock(&core_lock);
+	for (bin = large_bin(n); bin < LARGE_BINS && !b; bin++) {
+		prev = &large_free[bin];
+		for (scan = 0; scan < LARGE_SCAN && (b = *prev); scan++) {
+			if (header_of(b)->size >= n) {
+				break;
+			}
+			prev = &b->next;
+		}
+		if (scan == LARGE_SCAN) {
+			b = NULL;
+		}
+	}
+
+	if (b) {
+		*prev = b->next;
+		h = header_of(b);
+
+		/* Split off what is big enough to be worth keeping */
+		if (h->size - n >= sizeof(struct header) + MAX_SMALL) {
+			struct header *rest = (struct header *)((char *)b + n);
+
+			rest->size = h->size - n - sizeof(struct header);
+			rest->cpu = 0;
+			rest->kind = KIND_LARGE;
+			large_push(rest);
+			h->size = n;
+		}
+		spin_unlock(&core_lock);
+		return b;
+	}
+
+	h = (struct header *)morecore(r, sizeof(struct header) + n);
+	spin_unlock(&core_lock);
+	if (!h) {
+		return NULL;
+	}
+	h->size = n;
+	h->cpu = 0;
+	h->kind = KIND_LARGE;
+	return h + 1;
+}
+
+static void large_free_block(struct header *h)
+{
+	spin_lock(&core_lock);
+	large_push(h);
+	spin_unlock(&core_lock);
+}
+
+void *_malloc_r(struct _reent *r, size_t n)
+{
+	unsigned int key;
+	void *p;
+	int cpu;
+	int c;
+
+	if (n > SIZE_MAX / 2) {
+		r->_errno = ENOMEM;
+		return NULL;
+	}
+
+	cpu = __lfmalloc_cpu_enter(&key);
+	c = size_class(n ? n : 1);
+	if (c >= 0) {
+		p = small_alloc(r, cpu, c);
+	} else {
+		p = large_alloc(r, n);
+	}
+	__lfmalloc_cpu_exit(key);
+
+	if (!p) {
+		r->_errno = ENOMEM;
+	}
+	return p;
+}
+
+void _free_r(struct _reent *r, void *p)
+{
+	struct header *h;
+	unsigned int key;
+	int cpu;
+
+	(void)r;
+	if (!p) {
+		return;
+	}
+
+	h = header_of(p);
+	if (h->kind == KIND_ALIGNED) {
+		h = header_of((char *)p - h->size);
+	}
+
+	cpu = __lfmalloc_cpu_enter(&key);
+	if (h->kind == KIND_LARGE) {
+		large_free_block(h);
+	} else {
+		small_free(cpu, h);
+	}
+	__lfmalloc_cpu_exit(key);
+}
+
+size_t _malloc_usable_size_r(struct _reent *r, void *p)
+{
+	struct header *h;
+
+	(void)r;
+	if (!p) {
+		return 0;
+	}
+
+	h = header_of(p);
+	if (h->kind == KIND_ALIGNED) {
+		size_t offset = h->size;
+
+		return header_of((char *)p - offset)->size - offset;
+	}
+	return h->size;
+}
+
+void *_realloc_r(struct _reent *r, void *p, size_t n)
+{
+	size_t usable;
+	void *q;
+
+	if (!p) {
+		return _malloc_r(r, n);
+	}
+	if (!n) {
+		_free_r(r, p);
+		return NULL;
+	}
+
+	usable = _malloc_usable_size_r(r, p);
+	if (n <= usable && (n > usable / 2 || usable <= MAX_SMALL)) {
+		return p;
+	}
+
+	q = _malloc_r(r, n);
+	if (q) {
+		memcpy(q, p, n < usable ? n : usable);
+		_free_r(r, p);
+	}
+	return q;
+}
+
+void *_calloc_r(struct _reent *r, size_t count, size_t size)
+{
+	size_t n;
+	void *p;
+
+	if (__builtin_mul_overflow(count, size, &n)) {
+		r->_errno = ENOMEM;
+		return NULL;
+	}
+
+	p = _malloc_r(r, n);
+	if (p) {
+		memset(p, 0, n);
+	}
+	return p;
+}
+
+void *_memalign_r(struct _reent *r, size_t align, size_t n)
+{
+	struct header *h;
+	unsigned int key;
+	char *raw;
+	char *p;
+	int cpu;
+	int c;
+
+	if (align & (align - 1)) {
+		r->_errno = EINVAL;
+		return NULL;
+	}
+	if (align <= ALIGNMENT) {
+		return _malloc_r(r, n);
+	}
+	if (n > SIZE_MAX / 2 - align) {
+		r->_errno = ENOMEM;
+		return NULL;
+	}
+
+	n += align + sizeof(struct header);
+	cpu = __lfmalloc_cpu_enter(&key);
+	c = size_class(n);
+	raw = c >= 0 ? small_alloc(r, cpu, c) : large_alloc(r, n);
+	__lfmalloc_cpu_exit(key);
+	if (!raw) {
+		r->_errno = ENOMEM;
+		return NULL;
+	}
+
+	p = (char *)(((uintptr_t)raw + sizeof(struct header) + align - 1) &
+		     ~(uintptr_t)(align - 1));
+	h = header_of(p);
+	h->size = p - raw;
+	h->cpu = 0;
+	h->kind = KIND_ALIGNED;
+	return p;
+}
+
+void *malloc(size_t n)
+{
+	return _malloc_r(_REENT, n);
+}
+
+void free(void *p)
+{
+	_free_r(_REENT, p);
+}
+
+void *realloc(void *p, size_t n)
+{
+	return _realloc_r(_REENT, p, n);
+}
+
+void *calloc(size_t count, size_t size)
+{
+	return _calloc_r(_REENT, count, size);
+}
+
+void *memalign(size_t align, size_t n)
+{
+	return _memalign_r(_REENT, align, n);
+}
+
+size_t malloc_usable_size(void *p)
+{
+	return _malloc_usable_size_r(_REENT, p);
+}
+
+#endif
@@ -0,0 +1,24 @@
+/*
+ * The libc headers most Zephyr sources include, force included by
+ * -specs=pch.specs. When the SDK was installed with -pch, the
+ * zephyr-libc-pch.h.gch folder next to this file holds them precompiled
+ * for every multilib, and GCC takes the one that matches the compiler
+ * flags, or parses this file as usual when none does.
+ */
+
+#ifndef ZEPHYR_LIBC_PCH_H
+#define ZEPHYR_LIBC_PCH_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <ctype.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#endif /* ZEPHYR_LIBC_PCH_H */
@@ -0,0 +1,20 @@
+/*
+ * What a small application takes of the libc, linked by newlib_size_report
+ * to see how much --gc-sections drops
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+	char buf[32] = "";
+	char *p = malloc(64);
+
+	snprintf(buf, sizeof(buf), "%d %s", (int)strlen(argv[0]), "probe");
+	memcpy(p, buf, sizeof(buf));
+	printf("%s\n", p);
+	free(p);
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include <string.h>
+#include "zstring.h"
+
+#if ZSTR_ENABLED
+
+void *memcpy(void *__restrict dst0, const void *__restrict src0, size_t n)
+{
+	unsigned char *dst = dst0;
+	const unsigned char *src = src0;
+
+	if (n < ZSTR_SMALL) {
+		goto bytes;
+	}
+
+	while (UNALIGNED(dst)) {
+		*dst++ = *src++;
+		n--;
+	}
+
+	if (!UNALIGNED(src)) {
+		word_t *d = (word_t *)dst;
+		const word_t *s = (const word_t *)src;
+
+#if ZSTR_DWORD
+		while (n >= 8 * WSIZE) {
+			dword_t a = ((const dword_t *)s)[0];
+			dword_t b = ((const dword_t *)s)[1];
+			dword_t c = ((const dword_t *)s)[2];
+			dword_t e = ((const dword_t *)s)[3];
+
+			((dword_t *)d)[0] = a;
+			((dword_t *)d)[1] = b;
+			((dword_t *)d)[2] = c;
+			((dword_t *)d)[3] = e;
+			d += 8;
+			s += 8;
+			n -= 8 * WSIZE;
+		}
+#else
+		while (n >= 8 * WSIZE) {
+			d[0] = s[0];
+			d[1] = s[1];
+			d[2] = s[2];
+			d[3] = s[3];
+			d[4] = s[4];
+			d[5] = s[5];
+			d[6] = s[6];
+			d[7] = s[7];
+			d += 8;
+			s += 8;
+			n -= 8 * WSIZE;
+		}
+#endif
+		while (n >= WSIZE) {
+			*d++ = *s++;
+			n -= WSIZE;
+		}
+		dst = (unsigned char *)d;
+		src = (const unsigned char *)s;
+	} else if (ZSTR_UNALIGNED) {
+		word_t *d = (word_t *)dst;
+		const uword_t *s = (const uword_t *)src;
+
+		while (n >= 4 * WSIZE) {
+			d[0] = s[0];
+			d[1] = s[1];
+			d[2] = s[2];
+			d[3] = s[3];
+			d += 4;
+			s += 4;
+			n -= 4 * WSIZE;
+		}
+		while (n >= WSIZE) {
+			*d++ = *s++;
+			n -= WSIZE;
+		}
+		dst = (unsigned char *)d;
+		src = (const unsigned char *)s;
+	} else {
+		while (n >= 4) {
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+			dst[3] = src[3];
+			dst += 4;
+			src += 4;
+			n -= 4;
+		}
+	}
+
+bytes:
+	while (n--) {
+		*dst++ = *src++;
+	}
+	return dst0;
+}
+
+#endif
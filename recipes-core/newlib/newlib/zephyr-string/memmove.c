@@ -0,0 +1,80 @@
+#include <string.h>
+#include "zstring.h"
+
+#if ZSTR_ENABLED
+
+void *memmove(void *dst0, const void *src0, size_t n)
+{
+	unsigned char *dst = dst0;
+	const unsigned char *src = src0;
+
+	/* Copying forwards is safe unless the destination starts in the source */
+	if (dst <= src || dst >= src + n) {
+		if (n >= ZSTR_SMALL && UNALIGNED(dst) == UNALIGNED(src)) {
+			word_t *d;
+			const word_t *s;
+
+			while (UNALIGNED(dst)) {
+				*dst++ = *src++;
+				n--;
+			}
+
+			d = (word_t *)dst;
+			s = (const word_t *)src;
+			while (n >= WSIZE) {
+				*d++ = *s++;
+				n -= WSIZE;
+			}
+			dst = (unsigned char *)d;
+			src = (const unsigned char *)s;
+		}
+
+		while (n--) {
+			*dst++ = *src++;
+		}
+		return dst0;
+	}
+
+	dst += n;
+	src += n;
+
+	if (n >= ZSTR_SMALL && UNALIGNED(dst) == UNALIGNED(src)) {
+		word_t *d;
+		const word_t *s;
+
+		while (UNALIGNED(dst)) {
+			*--dst = *--src;
+			n--;
+		}
+
+		d = (word_t *)dst;
+		s = (const word_t *)src;
+		while (n >= 4 * WSIZE) {
+			word_t a = s[-1];
+			word_t b = s[-2];
+			word_t c = s[-3];
+			word_t e = s[-4];
+
+			d[-1] = a;
+			d[-2] = b;
+			d[-3] = c;
+			d[-4] = e;
+			d -= 4;
+			s -= 4;
+			n -= 4 * WSIZE;
+		}
+		while (n >= WSIZE) {
+			*--d = *--s;
+			n -= WSIZE;
+		}
+		dst = (unsigned char *)d;
+		src = (const unsigned char *)s;
+	}
+
+	while (n--) {
+		*--dst = *--src;
+	}
+	return dst0;
+}
+
+#endif
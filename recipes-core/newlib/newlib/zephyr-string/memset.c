@@ -0,0 +1,64 @@
+#include <string.h>
+#include "zstring.h"
+
+#if ZSTR_ENABLED
+
+void *memset(void *dst0, int c, size_t n)
+{
+	unsigned char *dst = dst0;
+	word_t *d;
+	word_t w;
+
+	if (n < ZSTR_SMALL) {
+		goto bytes;
+	}
+
+	while (UNALIGNED(dst)) {
+		*dst++ = (unsigned char)c;
+		n--;
+	}
+
+	w = ONES * (unsigned char)c;
+	d = (word_t *)dst;
+
+#if ZSTR_DWORD
+	{
+		dword_t dw = ((dword_t)w << 32) | w;
+
+		while (n >= 8 * WSIZE) {
+			((dword_t *)d)[0] = dw;
+			((dword_t *)d)[1] = dw;
+			((dword_t *)d)[2] = dw;
+			((dword_t *)d)[3] = dw;
+			d += 8;
+			n -= 8 * WSIZE;
+		}
+	}
+#else
+	while (n >= 8 * WSIZE) {
+		d[0] = w;
+		d[1] = w;
+		d[2] = w;
+		d[3] = w;
+		d[4] = w;
+		d[5] = w;
+		d[6] = w;
+		d[7] = w;
+		d += 8;
+		n -= 8 * WSIZE;
+	}
+#endif
+	while (n >= WSIZE) {
+		*d++ = w;
+		n -= WSIZE;
+	}
+	dst = (unsigned char *)d;
+
+bytes:
+	while (n--) {
+		*dst++ = (unsigned char)c;
+	}
+	return dst0;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#include <string.h>
+#include "zstring.h"
+
+#if ZSTR_ENABLED
+
+int strcmp(const char *s1, const char *s2)
+{
+	const unsigned char *a = (const unsigned char *)s1;
+	const unsigned char *b = (const unsigned char *)s2;
+
+	if (UNALIGNED(a) == UNALIGNED(b)) {
+		const word_t *wa;
+		const word_t *wb;
+
+		while (UNALIGNED(a)) {
+			if (*a != *b || !*a) {
+				return *a - *b;
+			}
+			a++;
+			b++;
+		}
+
+		/* Skip the words that are equal and hold no terminator */
+		wa = (const word_t *)a;
+		wb = (const word_t *)b;
+		while (*wa == *wb && !HAS_ZERO(*wa)) {
+			wa++;
+			wb++;
+		}
+		a = (const unsigned char *)wa;
+		b = (const unsigned char *)wb;
+	}
+
+	while (*a && *a == *b) {
+		a++;
+		b++;
+	}
+	return *a - *b;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#include <string.h>
+#include "zstring.h"
+
+#if ZSTR_ENABLED
+
+size_t strlen(const char *str)
+{
+	const char *s = str;
+	const word_t *w;
+
+	while (UNALIGNED(s)) {
+		if (!*s) {
+			return s - str;
+		}
+		s++;
+	}
+
+	/* Aligned loads never cross into the next page */
+	w = (const word_t *)s;
+	while (!HAS_ZERO(w[0])) {
+		if (HAS_ZERO(w[1])) {
+			w++;
+			break;
+		}
+		w += 2;
+	}
+
+	s = (const char *)w;
+	while (*s) {
+		s++;
+	}
+	return s - str;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Common definitions of the word-at-a-time string routines that replace
+ * the generic newlib ones in the multilibs listed below. For any other
+ * multilib the routines compile to nothing and newlib's own are kept.
+ */
+
+#ifndef ZSTRING_H
+#define ZSTRING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || \
+	defined(__riscv) || defined(__nios2__) || defined(__iamcu__) || \
+	defined(ZSTR_FORCE)
+#define ZSTR_ENABLED 1
+#else
+#define ZSTR_ENABLED 0
+#endif
+
+typedef unsigned long __attribute__((may_alias)) word_t;
+
+/* Word loads that may be unaligned, where the CPU supports them */
+typedef unsigned long __attribute__((may_alias, aligned(1))) uword_t;
+
+#if defined(__ARM_FEATURE_UNALIGNED) || defined(__i386__) || \
+	defined(__x86_64__)
+#define ZSTR_UNALIGNED 1
+#else
+#define ZSTR_UNALIGNED 0
+#endif
+
+/*
+ * Two words moved by a single LDRD/STRD, which only need word alignment on
+ * ARMv7-M and ARMv7E-M
+ */
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define ZSTR_DWORD 1
+typedef uint64_t __attribute__((may_alias, aligned(4))) dword_t;
+#else
+#define ZSTR_DWORD 0
+#endif
+
+#define WSIZE		sizeof(word_t)
+#define WMASK		(WSIZE - 1)
+#define ONES		((word_t)-1 / 0xff)
+#define HIGHS		(ONES << 7)
+
+/* Below this many bytes the word loops don't pay off */
+#define ZSTR_SMALL	(4 * WSIZE)
+
+#define UNALIGNED(p)	((uintptr_t)(p) & WMASK)
+
+/* Non-zero when a word contains a zero byte */
+#define HAS_ZERO(w)	(((w) - ONES) & ~(w) & HIGHS)
+
+#endif /* ZSTRING_H */
@@ -0,0 +1,17 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+float __addsf3_generic(float a, float b);
+
+float __addsf3(float a, float b)
+{
+	sf_t x = { a }, y = { b }, r;
+
+	if (sf_add(x.i, y.i, &r.i)) {
+		return r.f;
+	}
+	return __addsf3_generic(a, b);
+}
+
+#endif
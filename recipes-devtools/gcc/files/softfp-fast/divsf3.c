@@ -0,0 +1,45 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+float __divsf3_generic(float a, float b);
+
+float __divsf3(float a, float b)
+{
+	sf_t x = { a }, y = { b }, r;
+	uint32_t sign = (x.i ^ y.i) & SF_SIGN;
+	int ea = SF_EXP(x.i), eb = SF_EXP(y.i);
+	uint32_t ma, mb, q = 0;
+	int i;
+
+	if (SF_NORMAL(ea) && SF_NORMAL(eb)) {
+		ma = (x.i & SF_MANT) | SF_HIDDEN;
+		mb = (y.i & SF_MANT) | SF_HIDDEN;
+		ea -= eb - 127;
+		if (ma < mb) {
+			ma <<= 1;
+			ea--;
+		}
+		/*
+		 * Restoring division, 30 quotient bits put the leading one at
+		 * bit 29 and the remainder makes the sticky bit
+		 */
+		for (i = 0; i < 30; i++) {
+			q <<= 1;
+			if (ma >= mb) {
+				ma -= mb;
+				q |= 1;
+			}
+			ma <<= 1;
+		}
+		if (ea > 0 && sf_round(sign, ea, q | (ma != 0), &r.i)) {
+			return r.f;
+		}
+	} else if (!(x.i << 1) && SF_NORMAL(eb)) {
+		r.i = sign;
+		return r.f;
+	}
+	return __divsf3_generic(a, b);
+}
+
+#endif
@@ -0,0 +1,26 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+double __extendsfdf2_generic(float a);
+
+double __extendsfdf2(float a)
+{
+	sf_t x = { a };
+	df_t r;
+	int e = SF_EXP(x.i);
+
+	if (SF_NORMAL(e)) {
+		r.i = ((uint64_t)(x.i & SF_SIGN) << 32) |
+			((uint64_t)(e + 1023 - 127) << 52) |
+			((uint64_t)(x.i & SF_MANT) << 29);
+		return r.f;
+	}
+	if (!(x.i << 1)) {
+		r.i = (uint64_t)x.i << 32;
+		return r.f;
+	}
+	return __extendsfdf2_generic(a);
+}
+
+#endif
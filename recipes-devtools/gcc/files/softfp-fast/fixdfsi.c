@@ -0,0 +1,25 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+int __fixdfsi_generic(double a);
+
+int __fixdfsi(double a)
+{
+	df_t x = { a };
+	int e = DF_EXP(x.i);
+	uint32_t m;
+
+	if (e < 1023) {
+		return 0;
+	}
+	if (e >= 1054) {
+		return __fixdfsi_generic(a);
+	}
+	/* The 31 bits that can be left of the point */
+	m = (uint32_t)((x.i & DF_MANT) >> 22) | (1U << 30);
+	m >>= 1053 - e;
+	return (x.i & DF_SIGN) ? -(int)m : (int)m;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+int __fixsfsi_generic(float a);
+
+int __fixsfsi(float a)
+{
+	sf_t x = { a };
+	int e = SF_EXP(x.i);
+	uint32_t m;
+
+	/* |a| < 1, zero and denormals included */
+	if (e < 127) {
+		return 0;
+	}
+	/* |a| >= 2^31, infinities and NaNs included */
+	if (e >= 158) {
+		return __fixsfsi_generic(a);
+	}
+	m = (x.i & SF_MANT) | SF_HIDDEN;
+	m = e >= 150 ? m << (e - 150) : m >> (150 - e);
+	return (x.i & SF_SIGN) ? -(int)m : (int)m;
+}
+
+#endif
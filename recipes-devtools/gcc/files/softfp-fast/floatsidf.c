@@ -0,0 +1,26 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+double __floatsidf(int i)
+{
+	df_t r = { 0.0 };
+	uint64_t sign = 0;
+	uint32_t u = i;
+	int lz;
+
+	if (!u) {
+		return r.f;
+	}
+	if (i < 0) {
+		sign = DF_SIGN;
+		u = -u;
+	}
+	/* Always exact */
+	lz = __builtin_clz(u);
+	r.i = sign | ((uint64_t)(1054 - lz) << 52) |
+		(((uint64_t)u << (lz + 21)) & DF_MANT);
+	return r.f;
+}
+
+#endif
@@ -0,0 +1,25 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+float __floatsisf(int i)
+{
+	sf_t r = { 0.0f };
+	uint32_t sign = 0, u = i;
+	int lz;
+
+	if (!u) {
+		return r.f;
+	}
+	if (i < 0) {
+		sign = SF_SIGN;
+		u = -u;
+	}
+	lz = __builtin_clz(u);
+	u <<= lz;
+	/* Can't overflow */
+	sf_round(sign, 158 - lz, (u >> 2) | ((u & 3) != 0), &r.i);
+	return r.f;
+}
+
+#endif
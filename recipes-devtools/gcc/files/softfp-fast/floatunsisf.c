@@ -0,0 +1,19 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+float __floatunsisf(unsigned int u)
+{
+	sf_t r = { 0.0f };
+	int lz;
+
+	if (!u) {
+		return r.f;
+	}
+	lz = __builtin_clz(u);
+	u <<= lz;
+	sf_round(0, 158 - lz, (u >> 2) | ((u & 3) != 0), &r.i);
+	return r.f;
+}
+
+#endif
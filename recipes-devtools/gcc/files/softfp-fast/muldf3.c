@@ -0,0 +1,50 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+double __muldf3_generic(double a, double b);
+
+double __muldf3(double a, double b)
+{
+	df_t x = { a }, y = { b }, r;
+	uint64_t sign = (x.i ^ y.i) & DF_SIGN;
+	int ea = DF_EXP(x.i), eb = DF_EXP(y.i);
+	uint64_t ma, mb, p0, p1, p2, mid, lo, hi, m;
+	uint32_t al, ah, bl, bh;
+
+	if (DF_NORMAL(ea) && DF_NORMAL(eb)) {
+		ma = (x.i & DF_MANT) | DF_HIDDEN;
+		mb = (y.i & DF_MANT) | DF_HIDDEN;
+		al = (uint32_t)ma;
+		ah = (uint32_t)(ma >> 32);
+		bl = (uint32_t)mb;
+		bh = (uint32_t)(mb >> 32);
+
+		/* The 106 bit product from 32x32 bit multiplies, as hi:lo */
+		p0 = (uint64_t)al * bl;
+		p1 = (uint64_t)al * bh;
+		p2 = (uint64_t)ah * bl;
+		mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+		lo = (uint32_t)p0 | (mid << 32);
+		hi = (uint64_t)ah * bh + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+
+		/* The leading one is at bit 104 or 105, move it to bit 61 */
+		ea += eb - 1023;
+		if (hi & (1ULL << 41)) {
+			ea++;
+			m = (hi << 20) | (lo >> 44) | ((lo << 20) != 0);
+		} else {
+			m = (hi << 21) | (lo >> 43) | ((lo << 21) != 0);
+		}
+		if (ea > 0 && df_round(sign, ea, m, &r.i)) {
+			return r.f;
+		}
+	} else if ((!(x.i << 1) && DF_NORMAL(eb)) ||
+		   (!(y.i << 1) && DF_NORMAL(ea))) {
+		r.i = sign;
+		return r.f;
+	}
+	return __muldf3_generic(a, b);
+}
+
+#endif
@@ -0,0 +1,36 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+float __mulsf3_generic(float a, float b);
+
+float __mulsf3(float a, float b)
+{
+	sf_t x = { a }, y = { b }, r;
+	uint32_t sign = (x.i ^ y.i) & SF_SIGN;
+	int ea = SF_EXP(x.i), eb = SF_EXP(y.i);
+	uint64_t p;
+
+	if (SF_NORMAL(ea) && SF_NORMAL(eb)) {
+		p = (uint64_t)((x.i & SF_MANT) | SF_HIDDEN) *
+			((y.i & SF_MANT) | SF_HIDDEN);
+		ea += eb - 127;
+		/* The leading one is at bit 46 or 47, move it to 47 */
+		if (p & (1ULL << 47)) {
+			ea++;
+		} else {
+			p <<= 1;
+		}
+		if (ea > 0 && sf_round(sign, ea, (uint32_t)(p >> 18) |
+				       ((p & 0x3ffff) != 0), &r.i)) {
+			return r.f;
+		}
+	} else if ((!(x.i << 1) && SF_NORMAL(eb)) ||
+		   (!(y.i << 1) && SF_NORMAL(ea))) {
+		r.i = sign;
+		return r.f;
+	}
+	return __mulsf3_generic(a, b);
+}
+
+#endif
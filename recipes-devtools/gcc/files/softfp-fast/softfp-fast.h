@@ -0,0 +1,197 @@
+/*
+ * Fast paths of the soft-float routines of libgcc, for the multilibs
+ * listed below. An operation on normal numbers with a normal result is
+ * done here, with round to nearest even. Anything else (denormals,
+ * infinities, NaNs, overflow, underflow) goes to the generic soft-fp
+ * routine, which the recipe keeps in libgcc as <name>_generic, so the
+ * results are the same bit for bit.
+ */
+
+#ifndef SOFTFP_FAST_H
+#define SOFTFP_FAST_H
+
+#include <stdint.h>
+
+#if defined(__riscv) || defined(__nios2__) || defined(__iamcu__) || \
+	(defined(__i386__) && defined(_SOFT_FLOAT)) || defined(SOFTFP_FORCE)
+#define SOFTFP_ENABLED 1
+#else
+#define SOFTFP_ENABLED 0
+#endif
+
+typedef union { float f; uint32_t i; } sf_t;
+typedef union { double f; uint64_t i; } df_t;
+
+#define SF_SIGN		0x80000000U
+#define SF_MANT		0x007fffffU
+#define SF_HIDDEN	0x00800000U
+#define SF_EXP(a)	(((a) >> 23) & 0xff)
+
+#define DF_SIGN		0x8000000000000000ULL
+#define DF_MANT		0x000fffffffffffffULL
+#define DF_HIDDEN	0x0010000000000000ULL
+#define DF_EXP(a)	((int)((a) >> 52) & 0x7ff)
+
+/* Biased exponent of a normal number, unsigned so 0 wraps around too */
+#define SF_NORMAL(e)	((uint32_t)(e) - 1 < 254)
+#define DF_NORMAL(e)	((uint32_t)(e) - 1 < 2046)
+
+/*
+ * Rounds a float mantissa with the leading one at bit 29 and 6 more bits,
+ * the lowest of them sticky. Returns 0 on overflow.
+ */
+static inline int sf_round(uint32_t sign, int e, uint32_t m, uint32_t *r)
+{
+	uint32_t rest = m & 0x3f;
+
+	m >>= 6;
+	if (rest > 0x20 || (rest == 0x20 && (m & 1))) {
+		m++;
+		if (m == (SF_HIDDEN << 1)) {
+			m >>= 1;
+			e++;
+		}
+	}
+	if (e >= 255) {
+		return 0;
+	}
+	*r = sign | ((uint32_t)e << 23) | (m & SF_MANT);
+	return 1;
+}
+
+/* The same for a double mantissa with the leading one at bit 61 */
+static inline int df_round(uint64_t sign, int e, uint64_t m, uint64_t *r)
+{
+	uint32_t rest = (uint32_t)m & 0x1ff;
+
+	m >>= 9;
+	if (rest > 0x100 || (rest == 0x100 && (m & 1))) {
+		m++;
+		if (m == (DF_HIDDEN << 1)) {
+			m >>= 1;
+			e++;
+		}
+	}
+	if (e >= 2047) {
+		return 0;
+	}
+	*r = sign | ((uint64_t)e << 52) | (m & DF_MANT);
+	return 1;
+}
+
+static inline int sf_add(uint32_t a, uint32_t b, uint32_t *r)
+{
+	int ea = SF_EXP(a), eb = SF_EXP(b), d;
+	uint32_t ma, mb, m, t;
+
+	/* x + 0 is x */
+	if (!(b << 1) && SF_NORMAL(ea)) {
+		*r = a;
+		return 1;
+	}
+	if (!(a << 1) && SF_NORMAL(eb)) {
+		*r = b;
+		return 1;
+	}
+	if (!SF_NORMAL(ea) || !SF_NORMAL(eb)) {
+		return 0;
+	}
+
+	/* Make a the operand with the larger magnitude */
+	if ((a << 1) < (b << 1)) {
+		t = a;
+		a = b;
+		b = t;
+		d = ea;
+		ea = eb;
+		eb = d;
+	}
+
+	ma = ((a & SF_MANT) | SF_HIDDEN) << 6;
+	mb = ((b & SF_MANT) | SF_HIDDEN) << 6;
+	d = ea - eb;
+	if (d >= 32) {
+		mb = 1;
+	} else if (d) {
+		mb = (mb >> d) | ((mb << (32 - d)) != 0);
+	}
+
+	if ((a ^ b) & SF_SIGN) {
+		m = ma - mb;
+		if (!m) {
+			/* The sign of an exact zero is the generic code's job */
+			return 0;
+		}
+		d = __builtin_clz(m) - 2;
+		m <<= d;
+		ea -= d;
+		if (ea <= 0) {
+			return 0;
+		}
+	} else {
+		m = ma + mb;
+		if (m & (1U << 30)) {
+			m = (m >> 1) | (m & 1);
+			ea++;
+		}
+	}
+	return sf_round(a & SF_SIGN, ea, m, r);
+}
+
+static inline int df_add(uint64_t a, uint64_t b, uint64_t *r)
+{
+	int ea = DF_EXP(a), eb = DF_EXP(b), d;
+	uint64_t ma, mb, m, t;
+
+	if (!(b << 1) && DF_NORMAL(ea)) {
+		*r = a;
+		return 1;
+	}
+	if (!(a << 1) && DF_NORMAL(eb)) {
+		*r = b;
+		return 1;
+	}
+	if (!DF_NORMAL(ea) || !DF_NORMAL(eb)) {
+		return 0;
+	}
+
+	if ((a << 1) < (b << 1)) {
+		t = a;
+		a = b;
+		b = t;
+		d = ea;
+		ea = eb;
+		eb = d;
+	}
+
+	ma = ((a & DF_MANT) | DF_HIDDEN) << 9;
+	mb = ((b & DF_MANT) | DF_HIDDEN) << 9;
+	d = ea - eb;
+	if (d >= 64) {
+		mb = 1;
+	} else if (d) {
+		mb = (mb >> d) | ((mb << (64 - d)) != 0);
+	}
+
+	if ((a ^ b) & DF_SIGN) {
+		m = ma - mb;
+		if (!m) {
+			return 0;
+		}
+		d = __builtin_clzll(m) - 2;
+		m <<= d;
+		ea -= d;
+		if (ea <= 0) {
+			return 0;
+		}
+	} else {
+		m = ma + mb;
+		if (m & (1ULL << 62)) {
+			m = (m >> 1) | (m & 1);
+			ea++;
+		}
+	}
+	return df_round(a & DF_SIGN, ea, m, r);
+}
+
+#endif /* SOFTFP_FAST_H */
@@ -0,0 +1,17 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+double __subdf3_generic(double a, double b);
+
+double __subdf3(double a, double b)
+{
+	df_t x = { a }, y = { b }, r;
+
+	if (df_add(x.i, y.i ^ DF_SIGN, &r.i)) {
+		return r.f;
+	}
+	return __subdf3_generic(a, b);
+}
+
+#endif
@@ -0,0 +1,17 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+float __subsf3_generic(float a, float b);
+
+float __subsf3(float a, float b)
+{
+	sf_t x = { a }, y = { b }, r;
+
+	if (sf_add(x.i, y.i ^ SF_SIGN, &r.i)) {
+		return r.f;
+	}
+	return __subsf3_generic(a, b);
+}
+
+#endif
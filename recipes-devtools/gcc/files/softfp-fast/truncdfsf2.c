@@ -0,0 +1,27 @@
+#include "softfp-fast.h"
+
+#if SOFTFP_ENABLED
+
+float __truncdfsf2_generic(double a);
+
+float __truncdfsf2(double a)
+{
+	df_t x = { a };
+	sf_t r;
+	int e = DF_EXP(x.i) - 1023 + 127;
+	uint64_t m = (x.i & DF_MANT) | DF_HIDDEN;
+
+	/* The leading one from bit 52 to bit 29, the rest sticky */
+	if (SF_NORMAL(e) &&
+	    sf_round((uint32_t)(x.i >> 32) & SF_SIGN, e, (uint32_t)(m >> 23) |
+		     ((m & 0x7fffff) != 0), &r.i)) {
+		return r.f;
+	}
+	if (!(x.i << 1)) {
+		r.i = (uint32_t)(x.i >> 32);
+		return r.f;
+	}
+	return __truncdfsf2_generic(a);
+}
+
+#endif
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+#
+# Collects the buildstats of one or more SDK build folders (i.e.
+# poky/build-zephyr-arm) and reports the slowest tasks, with their CPU time,
+# wall time, peak RSS and I/O, as a table and optionally as JSON.
+#
+# Only the most recent build of each tmp*/buildstats folder is used.
+#
+
+import argparse
+import glob
+import json
+import os
+import sys
+
+
+def parse_task(path):
+    """Parse one buildstats task file into a dict of numbers."""
+    fields = {}
+    with open(path) as f:
+        for line in f:
+            key, sep, value = line.partition(':')
+            if sep:
+                fields[key.strip()] = value.strip()
+
+    def num(key):
+        try:
+            return float(fields.get(key, '0').split()[0])
+        except ValueError:
+            return 0.0
+
+    if 'Elapsed time' in fields:
+        wall = num('Elapsed time')
+    else:
+        wall = num('Ended') - num('Started')
+
+    cpu = (num('rusage ru_utime') + num('rusage ru_stime') +
+           num('Child rusage ru_utime') + num('Child rusage ru_stime'))
+
+    return {
+        'wall': round(wall, 2),
+        'cpu': round(cpu, 2),
+        'maxrss_kb': int(max(num('rusage ru_maxrss'),
+                             num('Child rusage ru_maxrss'))),
+        'read_bytes': int(num('IO read_bytes')),
+        'write_bytes': int(num('IO write_bytes')),
+        'status': fields.get('Status', 'UNKNOWN'),
+    }
+
+
+def collect(builddir):
+    """Yield one dict per task of the latest build of every tmpdir."""
+    build = os.path.basename(os.path.normpath(builddir))
+    for statsdir in sorted(glob.glob(os.path.join(builddir, 'tmp*', 'buildstats'))):
+        runs = sorted(d for d in os.listdir(statsdir)
+                      if os.path.isdir(os.path.join(statsdir, d)))
+        if not runs:
+            continue
+        rundir = os.path.join(statsdir, runs[-1])
+        tmpdir = os.path.basename(os.path.dirname(statsdir))
+        for recipe in sorted(os.listdir(rundir)):
+            recipedir = os.path.join(rundir, recipe)
+            if not os.path.isdir(recipedir):
+                continue
+            for task in sorted(os.listdir(recipedir)):
+                if not task.startswith('do_'):
+                    continue
+                stats = parse_task(os.path.join(recipedir, task))
+                stats.update({'build': build, 'tmpdir': tmpdir,
+                              'buildname': runs[-1], 'recipe': recipe,
+                              'task': task})
+                yield stats
+
+
+def human(nbytes):
+    for unit in ('B', 'K', 'M', 'G'):
+        if nbytes < 1024:
+            return '%.0f%s' % (nbytes, unit)
+        nbytes /= 1024.0
+    return '%.1fT' % nbytes
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Report the slowest tasks of Zephyr SDK builds.')
+    parser.add_argument('builddirs', nargs='+',
+                        help='bitbake build folders, i.e. poky/build-zephyr-arm')
+    parser.add_argument('-n', '--top', type=int, default=25,
+                        help='number of tasks to list (default: 25)')
+    parser.add_argument('-s', '--sort', default='wall',
+                        choices=('wall', 'cpu', 'maxrss_kb', 'read_bytes',
+                                 'write_bytes'),
+                        help='column to sort by (default: wall)')
+    parser.add_argument('-j', '--json',
+                        help='also write all tasks and totals to this file')
+    args = parser.parse_args()
+
+    tasks = []
+    for builddir in args.builddirs:
+        tasks.extend(collect(builddir))
+    if not tasks:
+        print('No buildstats found in %s' % ' '.join(args.builddirs),
+              file=sys.stderr)
+        return 1
+
+    tasks.sort(key=lambda t: t[args.sort], reverse=True)
+
+    totals = {}
+    for t in tasks:
+        total = totals.setdefault(t['build'], {'tasks': 0, 'wall': 0.0,
+                                               'cpu': 0.0, 'read_bytes': 0,
+                                               'write_bytes': 0})
+        total['tasks'] += 1
+        for key in ('wall', 'cpu', 'read_bytes', 'write_bytes'):
+            total[key] += t[key]
+
+    print('%-24s %-44s %-22s %9s %9s %8s %8s %8s' %
+          ('build', 'recipe', 'task', 'wall(s)', 'cpu(s)', 'maxrss',
+           'read', 'write'))
+    for t in tasks[:args.top]:
+        print('%-24s %-44s %-22s %9.1f %9.1f %8s %8s %8s' %
+              (t['build'], t['recipe'][:44], t['task'], t['wall'], t['cpu'],
+               human(t['maxrss_kb'] * 1024), human(t['read_bytes']),
+               human(t['write_bytes'])))
+    print('')
+    print('%-24s %8s %12s %12s' % ('build', 'tasks', 'task wall(s)', 'cpu(s)'))
+    for build in sorted(totals):
+        total = totals[build]
+        print('%-24s %8d %12.1f %12.1f' %
+              (build, total['tasks'], total['wall'], total['cpu']))
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump({'totals': totals, 'tasks': tasks}, f, indent=1,
+                      sort_keys=True)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
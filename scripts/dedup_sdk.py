@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+#
+# Hardlinks the identical files in the sysroots of an installed SDK and
+# reports the bytes saved. The host tools are shared already; what every
+# toolchain carries its own copy of are the arch independent files, i.e. the
+# newlib and gcc headers of the target sysroots, and the gcc plugin headers
+# and gdb data of each target in the host sysroot.
+#
+# setup.sh -dedup runs it once all toolchains are installed (and
+# relocated), so files are only shared when they are byte for byte the same
+# at their final location. Only regular files with the same mode and owner
+# are linked.
+#
+
+import argparse
+import hashlib
+import os
+import stat
+import sys
+
+
+def file_hash(path):
+    h = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for chunk in iter(lambda: f.read(1 << 20), b''):
+            h.update(chunk)
+    return h.digest()
+
+
+def scan(root, min_size):
+    """Group the regular files under root by (size, mode, owner)."""
+    groups = {}
+    for dirpath, dirnames, filenames in os.walk(root):
+        for name in filenames:
+            path = os.path.join(dirpath, name)
+            st = os.lstat(path)
+            if not stat.S_ISREG(st.st_mode) or st.st_size < min_size:
+                continue
+            key = (st.st_size, st.st_mode, st.st_uid, st.st_gid)
+            groups.setdefault(key, []).append((path, st.st_ino))
+    return groups
+
+
+def dedup(root, min_size, dry_run):
+    """Hardlink identical files, return (files linked, bytes saved)."""
+    linked = 0
+    saved = 0
+    for (size, mode, uid, gid), files in scan(root, min_size).items():
+        if len(set(ino for path, ino in files)) < 2:
+            continue
+
+        inodes = {}
+        for path, ino in sorted(files):
+            if ino in inodes:
+                continue
+            inodes[ino] = path
+
+        by_hash = {}
+        for ino, path in inodes.items():
+            by_hash.setdefault(file_hash(path), []).append(path)
+
+        for paths in by_hash.values():
+            target = paths[0]
+            for path in paths[1:]:
+                if not dry_run:
+                    tmp = path + '.dedup'
+                    os.link(target, tmp)
+                    os.replace(tmp, path)
+                linked += 1
+                saved += size
+    return linked, saved
+
+
+def human(nbytes):
+    for unit in ('B', 'K', 'M', 'G'):
+        if nbytes < 1024:
+            return '%.1f%s' % (nbytes, unit)
+        nbytes /= 1024.0
+    return '%.1fT' % nbytes
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Hardlink the identical files of an installed Zephyr SDK.')
+    parser.add_argument('sdkdir', help='SDK installation folder')
+    parser.add_argument('-m', '--min-size', type=int, default=1,
+                        help='ignore files smaller than this (default: 1)')
+    parser.add_argument('-n', '--dry-run', action='store_true',
+                        help='only report what would be saved')
+    args = parser.parse_args()
+
+    sysroots = os.path.join(args.sdkdir, 'sysroots')
+    if not os.path.isdir(sysroots):
+        print('No such folder: %s' % sysroots, file=sys.stderr)
+        return 1
+
+    linked, saved = dedup(sysroots, args.min_size, args.dry_run)
+    print('%s %d duplicate files, %s saved' %
+          ('Found' if args.dry_run else 'Linked', linked, human(saved)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,571 @@
+/*
+ * Times the hot paths of the libc and libgcc the SDK ships: string.h
+ * routines, malloc/free churn (also from several threads, which on SMP
+ * boards free each other's blocks), formatted I/O, stdio streams and
+ * soft-float arithmetic and libm. Results are printed as
+ * "BENCH <name> <cycles>" lines, which run-libc-bench.sh collects. Run under
+ * QEMU with -icount the cycle counts are deterministic. The accuracy of the
+ * float libm functions is reported the same way, as "BENCH ulp_<function>
+ * <largest error in ulps>", and the size of newlib's per thread state as
+ * "BENCH reent_size <bytes>".
+ */
+
+#include <zephyr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <reent.h>
+
+#define ITERATIONS 1000
+
+static char buf[256];
+static char src[1024], dst[1024];
+
+/* Keeps the compiler from optimizing away the results */
+volatile int sink;
+volatile float fsink;
+volatile double dsink;
+
+static void bench_memcpy(void)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		memcpy(dst, src, sizeof(src));
+	}
+}
+
+static void bench_memcpy_small(void)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS * 8; i++) {
+		memcpy(dst + (i & 7), src + (i & 3), 14 + (i & 15));
+	}
+}
+
+static void bench_memcpy_unaligned(void)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		memcpy(dst + 1, src + 2, sizeof(src) - 4);
+	}
+}
+
+static void bench_memmove(void)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		memmove(dst + 8, dst, sizeof(dst) - 8);
+	}
+}
+
+static void bench_memset(void)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		memset(dst + (i & 3), i, sizeof(dst) - 4);
+	}
+}
+
+static void bench_strlen(void)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		sink = strlen(src + (i & 3));
+	}
+}
+
+static void bench_strcmp(void)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		sink = strcmp(src, dst);
+	}
+}
+
+static void bench_malloc(void)
+{
+	void *p[16];
+	int i, j;
+
+	for (i = 0; i < ITERATIONS / 16; i++) {
+		for (j = 0; j < 16; j++) {
+			p[j] = malloc(16 + j * 24);
+		}
+		for (j = 0; j < 16; j += 2) {
+			free(p[j]);
+		}
+		for (j = 1; j < 16; j += 2) {
+			free(p[j]);
+		}
+	}
+}
+
+static void bench_realloc(void)
+{
+	void *p = NULL;
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		p = realloc(p, 8 + (i * 37) % 512);
+	}
+	free(p);
+}
+
+static void bench_snprintf(void)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		snprintf(buf, sizeof(buf), "%d %u 0x%08x %s %c", -i, i * 7,
+			 i * 13, "packet", 'a' + i % 26);
+	}
+}
+
+static void bench_sscanf(void)
+{
+	unsigned int a, b;
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		sscanf("1234 0x5678", "%u %x", &a, &b);
+	}
+}
+
+static void bench_fwrite(void)
+{
+	FILE *f;
+	int i;
+
+	f = fmemopen(buf, sizeof(buf), "w");
+	if (!f) {
+		return;
+	}
+	for (i = 0; i < ITERATIONS; i++) {
+		fseek(f, 0, SEEK_SET);
+		fwrite("0123456789abcdef", 1, 16, f);
+		fputs("header: value\n", f);
+	}
+	fclose(f);
+}
+
+static void bench_float(void)
+{
+	float a = 1.0001f, b = 0.5f;
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		b = b * a + 0.25f;
+		b = b / a - (float)i;
+	}
+	fsink = b;
+}
+
+static void bench_double(void)
+{
+	double a = 1.0001, b = 0.5;
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		b = b * a + 0.25;
+		b = b / a - (double)i;
+	}
+	dsink = b;
+}
+
+static void bench_int_div(void)
+{
+	volatile unsigned long long n = 0x123456789abcdefULL;
+	unsigned int r = 0;
+	int i;
+
+	for (i = 1; i <= ITERATIONS; i++) {
+		r += n / (unsigned int)(i * 7) + (unsigned int)n % (i * 3);
+	}
+	sink = r;
+}
+
+static void bench_libm(void)
+{
+	double x = 0.0;
+	int i;
+
+	for (i = 0; i < ITERATIONS / 4; i++) {
+		x += sqrt(i) + sin(i * 0.01) + exp(i * 0.001) + log(i + 1.0);
+	}
+	dsink = x;
+}
+
+static void bench_libm_float(void)
+{
+	float x = 0.0f;
+	int i;
+
+	for (i = 0; i < ITERATIONS / 4; i++) {
+		x += sqrtf(i) + sinf(i * 0.01f) + expf(i * 0.001f) +
+			logf(i + 1.0f);
+	}
+	fsink = x;
+}
+
+/* The single precision functions that have FPU fast paths in libm_fpu.a */
+static void bench_libm_fpu(void)
+{
+	float x = 0.0f, y = 0.0f;
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		float f = i * 0.37f;
+
+		x = fmaf(x, 0.999f, sqrtf(f)) + hypotf(f, y) * 1e-3f;
+		y = fabsf(floorf(f) - roundf(x)) + fminf(f, y) * 0.5f;
+	}
+	fsink = x + y;
+}
+
+#if defined(__riscv) || defined(__nios2__) || defined(__iamcu__) || \
+	(defined(__i386__) && defined(_SOFT_FLOAT))
+/*
+ * The soft-float routines of libgcc, and the generic ones the SDK's fast
+ * paths hand the unusual cases to, called directly to compare the two
+ */
+#define SOFTFP_BENCH 1
+
+struct softfp_ops {
+	float (*addsf3)(float, float);
+	float (*mulsf3)(float, float);
+	float (*divsf3)(float, float);
+	int (*fixsfsi)(float);
+	double (*adddf3)(double, double);
+	double (*muldf3)(double, double);
+	double (*extendsfdf2)(float);
+	float (*truncdfsf2)(double);
+};
+
+float __addsf3(float, float);
+float __mulsf3(float, float);
+float __divsf3(float, float);
+int __fixsfsi(float);
+double __adddf3(double, double);
+double __muldf3(double, double);
+double __extendsfdf2(float);
+float __truncdfsf2(double);
+
+float __addsf3_generic(float, float) __attribute__((weak));
+float __mulsf3_generic(float, float) __attribute__((weak));
+float __divsf3_generic(float, float) __attribute__((weak));
+int __fixsfsi_generic(float) __attribute__((weak));
+double __adddf3_generic(double, double) __attribute__((weak));
+double __muldf3_generic(double, double) __attribute__((weak));
+double __extendsfdf2_generic(float) __attribute__((weak));
+float __truncdfsf2_generic(double) __attribute__((weak));
+
+static const struct softfp_ops softfp_fast = {
+	__addsf3, __mulsf3, __divsf3, __fixsfsi,
+	__adddf3, __muldf3, __extendsfdf2, __truncdfsf2,
+};
+
+static const struct softfp_ops softfp_generic = {
+	__addsf3_generic, __mulsf3_generic, __divsf3_generic, __fixsfsi_generic,
+	__adddf3_generic, __muldf3_generic, __extendsfdf2_generic,
+	__truncdfsf2_generic,
+};
+
+static void softfp_run(const struct softfp_ops *ops)
+{
+	float a = 1.0001f, b = 0.5f;
+	double c = 0.5001, d = 0.5;
+	int i, n = 0;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		b = ops->addsf3(ops->mulsf3(b, a), 0.25f);
+		b = ops->divsf3(b, a);
+		n += ops->fixsfsi(b);
+		d = ops->adddf3(ops->muldf3(d, c), ops->extendsfdf2(b));
+		b = ops->truncdfsf2(ops->muldf3(d, 0.125));
+	}
+	sink = n;
+	fsink = b;
+	dsink = d;
+}
+
+static void bench_softfp(void)
+{
+	softfp_run(&softfp_fast);
+}
+
+static void bench_softfp_generic(void)
+{
+	softfp_run(&softfp_generic);
+}
+#endif
+
+static u32_t ulp_error(float f, double ref)
+{
+	union { float f; s32_t i; } a = { f }, b = { (float)ref };
+
+	/* Maps the floats onto integers in the same order */
+	a.i = a.i < 0 ? INT32_MIN - a.i : a.i;
+	b.i = b.i < 0 ? INT32_MIN - b.i : b.i;
+	return a.i > b.i ? (u32_t)a.i - b.i : (u32_t)b.i - a.i;
+}
+
+#define MAX_ERROR(e, f, ref) do { \
+	u32_t __e = ulp_error(f, ref); \
+	e = __e > e ? __e : e; \
+} while (0)
+
+/*
+ * Compares the float functions against the double ones rounded to float,
+ * for inputs spread over the exponents they are usually called with
+ */
+static void libm_accuracy(void)
+{
+	u32_t e_sqrt = 0, e_hypot = 0, e_fma = 0, e_sin = 0, e_exp = 0;
+	u32_t e_log = 0;
+	u32_t seed = 1;
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		union { u32_t i; float f; } x, y, z;
+
+		seed = seed * 1103515245 + 12345;
+		x.i = (seed & 0x7fffff) | ((107 + (seed >> 24) % 40) << 23);
+		seed = seed * 1103515245 + 12345;
+		y.i = (seed & 0x807fffff) | ((107 + (seed >> 24) % 40) << 23);
+		z.f = y.f * 0.75f;
+
+		MAX_ERROR(e_sqrt, sqrtf(x.f), sqrt(x.f));
+		MAX_ERROR(e_hypot, hypotf(x.f, y.f), hypot(x.f, y.f));
+		/* The product of two floats is exact in a double */
+		MAX_ERROR(e_fma, fmaf(x.f, y.f, z.f),
+			  (double)x.f * y.f + z.f);
+		MAX_ERROR(e_sin, sinf(fmodf(x.f, 100.0f)),
+			  sin(fmodf(x.f, 100.0f)));
+		MAX_ERROR(e_exp, expf(fmodf(y.f, 80.0f)),
+			  exp(fmodf(y.f, 80.0f)));
+		MAX_ERROR(e_log, logf(x.f), log(x.f));
+	}
+
+	printf("BENCH ulp_sqrtf %u\n", e_sqrt);
+	printf("BENCH ulp_hypotf %u\n", e_hypot);
+	printf("BENCH ulp_fmaf %u\n", e_fma);
+	printf("BENCH ulp_sinf %u\n", e_sin);
+	printf("BENCH ulp_expf %u\n", e_exp);
+	printf("BENCH ulp_logf %u\n", e_log);
+}
+
+/*
+ * Threads that each allocate blocks and hand them to the next one to free,
+ * so that on SMP most blocks are freed on another CPU than they came from
+ */
+#define STRESS_THREADS 4
+#define STRESS_ROUNDS 500
+
+K_THREAD_STACK_ARRAY_DEFINE(stress_stacks, STRESS_THREADS, 1024);
+static struct k_thread stress_threads[STRESS_THREADS];
+static struct k_fifo stress_fifo[STRESS_THREADS];
+static struct k_sem stress_done;
+
+static void stress_thread(void *p1, void *p2, void *p3)
+{
+	int id = (int)p1;
+	struct k_fifo *next = &stress_fifo[(id + 1) % STRESS_THREADS];
+	void *p;
+	int i;
+
+	for (i = 0; i < STRESS_ROUNDS; i++) {
+		p = malloc(16 + (i * 40 + id * 8) % 600);
+		if (p) {
+			k_fifo_put(next, p);
+		}
+		while ((p = k_fifo_get(&stress_fifo[id], K_NO_WAIT))) {
+			free(p);
+		}
+		if (!(i & 7)) {
+			k_yield();
+		}
+	}
+	k_sem_give(&stress_done);
+}
+
+static void bench_malloc_stress(void)
+{
+	void *p;
+	int i;
+
+	k_sem_init(&stress_done, 0, STRESS_THREADS);
+	for (i = 0; i < STRESS_THREADS; i++) {
+		k_fifo_init(&stress_fifo[i]);
+	}
+	for (i = 0; i < STRESS_THREADS; i++) {
+		k_thread_create(&stress_threads[i], stress_stacks[i],
+				K_THREAD_STACK_SIZEOF(stress_stacks[i]),
+				stress_thread, (void *)i, NULL, NULL,
+				K_PRIO_COOP(5), 0, K_NO_WAIT);
+	}
+	for (i = 0; i < STRESS_THREADS; i++) {
+		k_sem_take(&stress_done, K_FOREVER);
+	}
+	for (i = 0; i < STRESS_THREADS; i++) {
+		while ((p = k_fifo_get(&stress_fifo[i], K_NO_WAIT))) {
+			free(p);
+		}
+	}
+}
+
+static void bench_errno(void)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		errno = i;
+		sink += errno;
+	}
+}
+
+/*
+ * Two threads waking each other up, and using errno each time, so that the
+ * reent lookup is part of the switch as it is in libc calls after one
+ */
+K_THREAD_STACK_DEFINE(switch_stack, 1024);
+static struct k_thread switch_thread;
+static struct k_sem switch_ping, switch_pong;
+
+static void switch_entry(void *p1, void *p2, void *p3)
+{
+	int i;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		k_sem_take(&switch_ping, K_FOREVER);
+		errno = 0;
+		k_sem_give(&switch_pong);
+	}
+}
+
+static void bench_context_switch(void)
+{
+	int i;
+
+	k_sem_init(&switch_ping, 0, 1);
+	k_sem_init(&switch_pong, 0, 1);
+	k_thread_create(&switch_thread, switch_stack,
+			K_THREAD_STACK_SIZEOF(switch_stack), switch_entry,
+			NULL, NULL, NULL, K_PRIO_COOP(5), 0, K_NO_WAIT);
+	for (i = 0; i < ITERATIONS; i++) {
+		k_sem_give(&switch_ping);
+		k_sem_take(&switch_pong, K_FOREVER);
+		errno = 0;
+	}
+}
+
+#ifdef LIBC_REENT
+/*
+ * The reent variant of newlib gets the reent from here. Each thread gets
+ * its own on its first libc call, kept in its custom data, so errno and
+ * stdio are per thread and nothing is switched with the threads.
+ */
+#define REENT_POOL (STRESS_THREADS + 2)
+
+static struct _reent reent_pool[REENT_POOL];
+static atomic_t reent_used;
+
+struct _reent *__getreent(void)
+{
+	struct _reent *r = k_thread_custom_data_get();
+	int i;
+
+	if (!r) {
+		i = atomic_inc(&reent_used);
+		if (i < REENT_POOL) {
+			r = &reent_pool[i];
+			_REENT_INIT_PTR(r);
+		} else {
+			r = _impure_ptr;
+		}
+		k_thread_custom_data_set(r);
+	}
+	return r;
+}
+#endif
+
+#ifdef LIBC_LFMALLOC
+/* Keeps lfmalloc on the current CPU, see lfmalloc.c in the SDK's newlib */
+int __lfmalloc_cpu_enter(unsigned int *key)
+{
+#ifdef CONFIG_SMP
+	*key = _arch_irq_lock();
+	return _arch_curr_cpu()->id;
+#else
+	*key = irq_lock();
+	return 0;
+#endif
+}
+
+void __lfmalloc_cpu_exit(unsigned int key)
+{
+#ifdef CONFIG_SMP
+	_arch_irq_unlock(key);
+#else
+	irq_unlock(key);
+#endif
+}
+#endif
+
+static void run(const char *name, void (*fn)(void))
+{
+	u32_t start = k_cycle_get_32();
+
+	fn();
+	printf("BENCH %s %u\n", name, k_cycle_get_32() - start);
+}
+
+void main(void)
+{
+	memset(src, 'x', sizeof(src) - 1);
+	memset(dst, 'x', sizeof(dst) - 1);
+	dst[sizeof(dst) - 2] = 'y';
+
+	run("memcpy", bench_memcpy);
+	run("memcpy_small", bench_memcpy_small);
+	run("memcpy_unaligned", bench_memcpy_unaligned);
+	run("memmove", bench_memmove);
+	run("memset", bench_memset);
+	run("strlen", bench_strlen);
+	run("strcmp", bench_strcmp);
+	run("malloc", bench_malloc);
+	run("realloc", bench_realloc);
+#if !defined(CONFIG_SMP) || defined(LIBC_LFMALLOC)
+	/* The newlib malloc isn't safe on SMP, Zephyr has no __malloc_lock */
+	run("malloc_stress", bench_malloc_stress);
+#endif
+	run("errno", bench_errno);
+	run("context_switch", bench_context_switch);
+	printf("BENCH reent_size %u\n", (unsigned int)sizeof(struct _reent));
+	run("snprintf", bench_snprintf);
+	run("sscanf", bench_sscanf);
+	run("fwrite", bench_fwrite);
+	run("float", bench_float);
+	run("double", bench_double);
+	run("int_div", bench_int_div);
+	run("libm", bench_libm);
+	run("libm_float", bench_libm_float);
+	run("libm_fpu", bench_libm_fpu);
+#ifdef SOFTFP_BENCH
+	run("softfp", bench_softfp);
+	/* Only in a libgcc with the fast paths */
+	if (__addsf3_generic) {
+		run("softfp_generic", bench_softfp_generic);
+	}
+#endif
+	libm_accuracy();
+	printf("BENCH done\n");
+}
@@ -0,0 +1,52 @@
+#!/bin/bash
+#
+# Precompiles zephyr-libc-pch.h, the libc headers -specs=pch.specs force
+# includes, for every multilib of the toolchains installed in an SDK. GCC
+# only loads a PCH made by the very same compiler binary, so this runs
+# with the installed compilers, from setup.sh -pch, rather than when the
+# SDK is built.
+#
+# A PCH is only used when the flags of a compilation match those it was
+# made with. PCH_VARIANTS are the optimization levels of Zephyr builds,
+# and PCH_FLAGS the other flags they all have that change what the libc
+# headers define (-ffreestanding selects GCC's own stdint.h, -std=c99 sets
+# __STRICT_ANSI__). -Winvalid-pch tells why a compilation doesn't use one.
+#
+#   ./make_pch.sh /opt/zephyr-sdk
+#
+
+PCH_HEADER=zephyr-libc-pch.h
+PCH_VARIANTS=${PCH_VARIANTS:-"-Os -O2 -Og"}
+PCH_FLAGS=${PCH_FLAGS:-"-g -std=c99 -ffreestanding"}
+
+sdk=$1
+if [ -z "$sdk" -o ! -d "$sdk/sysroots" ]; then
+	echo "Usage: $(basename $0) <sdk dir>"
+	exit 1
+fi
+
+failed=0
+for gcc in $(find $sdk/sysroots -path "*/usr/bin/*" -name "*-zephyr-*-gcc" -type f | sort); do
+	header=$($gcc -print-sysroot)/usr/include/$PCH_HEADER
+	if [ ! -f $header ]; then
+		echo "Skipping $(basename $gcc), it has no $PCH_HEADER"
+		continue
+	fi
+
+	gch=$header.gch
+	rm -rf $gch && mkdir -p $gch
+	echo "Precompiling $PCH_HEADER for $(basename $gcc)..."
+	$gcc -print-multi-lib | while read multilib; do
+		dir=${multilib%%;*}
+		flags=$(echo ${multilib#*;} | sed 's/@/ -/g')
+		for variant in $PCH_VARIANTS; do
+			# GCC tries every file in the .gch folder, the names only
+			# have to be unique
+			name=$(echo "$dir$variant" | tr '/.' '_')
+			$gcc $flags $variant $PCH_FLAGS -x c-header $header \
+				-o $gch/$name.gch || exit 1
+		done
+	done || failed=1
+done
+
+exit $failed
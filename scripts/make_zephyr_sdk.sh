@@ -40,10 +40,37 @@ version_minor=9
 subversion_minor=5
 prerelease=
 
-if [ "$1" != "" ] ; then
-    product_name=$1
-  else
-    product_name=zephyr-sdk
+product_name=zephyr-sdk
+compression=xz
+delta_old=
+delta_new=
+delta_prefix=
+
+while [ "$1" != "" ]; do
+    case $1 in
+        -compression )
+            shift
+            compression=$1
+            ;;
+        -delta )
+            delta_old=$2
+            delta_new=$3
+            shift 2
+            ;;
+        -prefix )
+            shift
+            delta_prefix=$1
+            ;;
+        * )
+            product_name=$1
+            ;;
+    esac
+    shift
+done
+
+if [ "$compression" != "xz" -a "$compression" != "zstd" ]; then
+    echo "Error: Unknown compression \"$compression\", use xz or zstd"
+    exit 1
 fi
 
 # Create ./setup.sh
@@ -63,6 +90,101 @@ default_dir=/opt/${product_name}/
 toolchain_name=${product_name}-${sdk_version}-setup.run
 version_dir=info-zephyr-sdk-${sdk_version}
 
+# sdk_prefix <tree>, prints the folder that the SDK copied to <tree> was
+# installed to, from the dynamic loader its host binaries were relocated to
+sdk_prefix()
+{
+    local file
+
+    for file in $1/sysroots/*-pokysdk-linux/usr/bin/*; do
+        [ -f "$file" -a ! -L "$file" ] || continue
+        readelf -l "$file" 2> /dev/null | \
+            sed -n "s|.*program interpreter: \(.*\)/sysroots/.*|\1|p" | grep . && return
+    done
+}
+
+# make_delta <old_tree> <new_tree>, creates an update installer from two
+# SDKs that were installed with the same prefix (and then copied to the two
+# trees). It holds the files that were added or changed in <new_tree> and
+# the list of those that were removed, see template_update.
+make_delta()
+{
+    local base_version
+    local new_version
+    local update_name
+    local old_prefix
+    local new_prefix
+    local work
+
+    if [ ! -f "$1/sdk_version" -o ! -f "$2/sdk_version" ]; then
+        echo "Error: -delta needs two installed SDKs"
+        exit 1
+    fi
+    if ls $1/info-zephyr-sdk-*/arches $2/info-zephyr-sdk-*/arches 2> /dev/null | grep -q .; then
+        echo "Error: -delta needs two complete SDKs, installed without --arch"
+        exit 1
+    fi
+    old_prefix=$(readlink -m "$(sdk_prefix $1)")
+    new_prefix=$(readlink -m "$(sdk_prefix $2)")
+    if [ "$old_prefix" = "/" -o "$old_prefix" != "$new_prefix" ]; then
+        echo "Error: -delta needs two SDKs installed with the same prefix," \
+             "found \"$old_prefix\" and \"$new_prefix\""
+        exit 1
+    fi
+    if [ -n "$delta_prefix" -a "$(readlink -m "$delta_prefix")" != "$old_prefix" ]; then
+        echo "Error: The SDKs were installed in $old_prefix, not $delta_prefix"
+        exit 1
+    fi
+    base_version=$(cat $1/sdk_version)
+    new_version=$(cat $2/sdk_version)
+    update_name=${product_name}-${base_version}-to-${new_version}-update.run
+
+    work=$(mktemp -d)
+    (cd $1 && find . ! -type d ! -name sdk_version | sort) > $work/old.list
+    (cd $2 && find . ! -type d ! -name sdk_version | sort) > $work/new.list
+    (cd $1 && find . -mindepth 1 -type d | sort) > $work/old-dirs.list
+    (cd $2 && find . -mindepth 1 -type d | sort) > $work/new-dirs.list
+
+    mkdir $work/update
+    comm -23 $work/old.list $work/new.list > $work/update/removed.list
+    comm -23 $work/old-dirs.list $work/new-dirs.list > $work/update/removed-dirs.list
+    comm -13 $work/old-dirs.list $work/new-dirs.list > $work/changed.list
+    comm -13 $work/old.list $work/new.list >> $work/changed.list
+    comm -12 $work/old.list $work/new.list | while read file; do
+        if [ -L "$1/$file" -o -L "$2/$file" ]; then
+            [ "$(readlink "$1/$file")" = "$(readlink "$2/$file")" ] && \
+                [ -L "$1/$file" -a -L "$2/$file" ] && continue
+        elif cmp -s "$1/$file" "$2/$file"; then
+            continue
+        fi
+        echo "$file"
+    done >> $work/changed.list
+
+    echo "$(wc -l < $work/changed.list) files and folders added or changed," \
+         "$(wc -l < $work/update/removed.list) removed"
+
+    tar cf $work/update/files.tar -C $2 --no-recursion -T $work/changed.list
+    cp dedup_sdk.py make_pch.sh $work/update/
+
+    echo '#!/bin/bash' > $work/update/update.sh
+    echo "UPDATE_NAME=$update_name" >> $work/update/update.sh
+    echo "BASE_VERSION=$base_version" >> $work/update/update.sh
+    echo "BASE_VERSION_DIR=info-zephyr-sdk-$base_version" >> $work/update/update.sh
+    echo "SDK_VERSION=$new_version" >> $work/update/update.sh
+    echo "DELTA_PREFIX=$old_prefix" >> $work/update/update.sh
+    cat template_update >> $work/update/update.sh
+    chmod 755 $work/update/update.sh
+
+    makeself --xz $work/update/ $update_name "SDK update for Zephyr" ./update.sh
+    status=$?
+    rm -rf $work
+    exit $status
+}
+
+if [ -n "$delta_old" ]; then
+    make_delta $delta_old $delta_new
+fi
+
 # Identify files present in toolchains folder
 
 parse_toolchain_name()
@@ -102,78 +224,152 @@ if  [ -z "$file_hosttools" ]; then
   exit 1
 fi
 
-echo '#!/bin/bash' > $setup
-echo "DEFAULT_INSTALL_DIR=$default_dir" >> $setup
-echo "TOOLCHAIN_NAME=$toolchain_name" >> $setup
-echo "VERSION_DIR=$version_dir" >> $setup
-echo "SDK_VERSION=${sdk_version}" >> $setup
+toolchains="$file_gcc_x86 $file_gcc_arm $file_gcc_arc $file_gcc_iamcu \
+            $file_gcc_mips $file_gcc_nios2 $file_gcc_xtensa $file_gcc_riscv32"
 
-cat template_dir >>$setup
+# unpack_payload <file>, writes the xz payload that follows the MARKER: line
+# of a toolchain installer to <file>.tar, and the installer script before it
+# to <file>.new. With -compression zstd the script extracts zstd instead.
+unpack_payload()
+{
+    local installer=toolchains/$1
+    local line
 
-if [ -n "$file_gcc_x86" ]; then
-  echo "./$file_gcc_x86 -R -y -d \$target_sdk_dir > /dev/null &" >> $setup
-  echo "spinner \$! \"Installing x86 tools...\"" >> $setup
-  echo "[ \$? -ne 0 ] && echo \"Error(s) encountered during installation.\" && exit 1" >>$setup
-  echo "echo \"\"" >>$setup
-fi
+    line=$(grep -na -m1 "^MARKER:$" $installer | cut -d':' -f1)
+    if [ -z "$line" ] || ! head -n $line $installer | grep -q "tar mxJ"; then
+        echo "Error: Unknown payload format of \"$1\""
+        exit 1
+    fi
 
-if [ -n "$file_gcc_arm" ]; then
-  echo "./$file_gcc_arm -R -y -d \$target_sdk_dir > /dev/null &" >> $setup
-  echo "spinner \$! \"Installing arm tools...\"" >> $setup
-  echo "[ \$? -ne 0 ] && echo \"Error(s) encountered during installation.\" && exit 1" >>$setup
-  echo "echo \"\"" >>$setup
-fi
+    echo "Unpacking $1..."
+    if [ "$compression" = "zstd" ]; then
+        head -n $line $installer | sed "s/tar mxJ/tar mx -I zstd/" > $installer.new
+    else
+        head -n $line $installer > $installer.new
+    fi
+    if ! tail -n +$((line + 1)) $installer | xz -d -T0 > $installer.tar; then
+        echo "Error: Extracting the payload of \"$1\" failed"
+        rm -f $installer.new $installer.tar
+        exit 1
+    fi
+}
 
-if [ -n "$file_gcc_arc" ]; then
-  echo "./$file_gcc_arc -R -y -d \$target_sdk_dir > /dev/null &" >> $setup
-  echo "spinner \$!  \"Installing arc tools...\"" >> $setup
-  echo "[ \$? -ne 0 ] && echo \"Error(s) encountered during installation.\" && exit 1" >>$setup
-  echo "echo \"\"" >>$setup
-fi
+# pack_payload <file>, compresses <file>.tar again behind <file>.new and
+# replaces the installer with it. zstd extracts several times faster than xz.
+pack_payload()
+{
+    local installer=toolchains/$1
+    local compress
 
-if [ -n "$file_gcc_iamcu" ]; then
-  echo "./$file_gcc_iamcu -R -y -d \$target_sdk_dir > /dev/null &" >> $setup
-  echo "spinner \$!  \"Installing iamcu tools...\"" >> $setup
-  echo "[ \$? -ne 0 ] && echo \"Error(s) encountered during installation.\" && exit 1" >>$setup
-  echo "echo \"\"" >>$setup
-fi
+    echo "Repacking $1..."
+    if [ "$compression" = "zstd" ]; then
+        compress="zstd -q -T0 -19"
+    else
+        compress="xz -T0 -9 --block-size=32MiB"
+    fi
+    if ! $compress < $installer.tar >> $installer.new; then
+        echo "Error: Recompressing \"$1\" failed"
+        rm -f $installer.new $installer.tar
+        exit 1
+    fi
+    rm -f $installer.tar
+    chmod --reference=$installer $installer.new
+    mv $installer.new $installer
+}
 
-if [ -n "$file_gcc_mips" ]; then
-  echo "./$file_gcc_mips -R -y -d \$target_sdk_dir > /dev/null &" >> $setup
-  echo "spinner \$!  \"Installing mips tools...\"" >> $setup
-  echo "[ \$? -ne 0 ] && echo \"Error(s) encountered during installation.\" && exit 1" >>$setup
-  echo "echo \"\"" >>$setup
-fi
+# share_files, leaves the files that several toolchains ship (the nativesdk
+# libc and loader, gmp/mpfr/mpc, relocate_sdk.py...) to hosttools. They are
+# removed from the toolchain payloads and the ones hosttools doesn't ship yet
+# are moved to its payload. setup.sh -j runs the toolchain installers at the
+# same time, and installs hosttools once they are all done, so no file of
+# the shared host sysroot is written by two installers. Hardlinked files are
+# left where they are, as tar can't extract a link without its target.
+share_files()
+{
+    local work=toolchains/share
+    local file
 
-if [ -n "$file_gcc_nios2" ]; then
-  echo "./$file_gcc_nios2 -R -y -d \$target_sdk_dir > /dev/null &" >> $setup
-  echo "spinner \$!  \"Installing nios2 tools...\"" >> $setup
-  echo "[ \$? -ne 0 ] && echo \"Error(s) encountered during installation.\" && exit 1" >>$setup
-  echo "echo \"\"" >>$setup
-fi
+    rm -rf $work && mkdir -p $work/files
+    for file in $toolchains $file_hosttools; do
+        tar tvf toolchains/$file.tar | awk '$1 ~ /^h/ { print $6; print $9 }'
+    done | sort -u > $work/hardlinks.list
+    for file in $toolchains $file_hosttools; do
+        tar tf toolchains/$file.tar | grep -v "/$" | sort -u | \
+            comm -23 - $work/hardlinks.list > $work/$file.list
+    done
 
-if [ -n "$file_gcc_xtensa" ]; then
-  echo "./$file_gcc_xtensa -R -y -d \$target_sdk_dir > /dev/null &" >> $setup
-  echo "spinner \$!  \"Installing xtensa tools...\"" >> $setup
-  echo "[ \$? -ne 0 ] && echo \"Error(s) encountered during installation.\" && exit 1" >>$setup
-  echo "echo \"\"" >>$setup
-fi
+    cat /dev/null $(for file in $toolchains; do echo $work/$file.list; done) | \
+        sort | uniq -d > $work/shared.list
+    comm -23 $work/shared.list $work/$file_hosttools.list > $work/move.list
+    sort -u $work/shared.list $work/$file_hosttools.list > $work/strip.list
+    echo "$(wc -l < $work/shared.list) files shared by the toolchains," \
+         "$(wc -l < $work/move.list) of them moved to hosttools"
 
-if [ -n "$file_gcc_riscv32" ]; then
-  echo "./$file_gcc_riscv32 -R -y -d \$target_sdk_dir > /dev/null &" >> $setup
-  echo "spinner \$!  \"Installing riscv32 tools...\"" >> $setup
-  echo "[ \$? -ne 0 ] && echo \"Error(s) encountered during installation.\" && exit 1" >>$setup
-  echo "echo \"\"" >>$setup
-fi
+    cp $work/move.list $work/todo.list
+    for file in $toolchains; do
+        comm -12 $work/$file.list $work/todo.list > $work/extract.list
+        if [ -s $work/extract.list ]; then
+            tar xpf toolchains/$file.tar -C $work/files -T $work/extract.list || exit 1
+            comm -23 $work/todo.list $work/extract.list > $work/todo.new
+            mv $work/todo.new $work/todo.list
+        fi
+        comm -12 $work/$file.list $work/strip.list > $work/delete.list
+        if [ -s $work/delete.list ]; then
+            tar --delete -f toolchains/$file.tar -T $work/delete.list || exit 1
+        fi
+    done
+    if [ -s $work/move.list ]; then
+        tar rf toolchains/$file_hosttools.tar --owner=root --group=root \
+            -C $work/files -T $work/move.list || exit 1
+    fi
+    rm -rf $work
+}
 
-if [ -n "$file_hosttools" ]; then
-  echo "./$file_hosttools -y -d \$target_sdk_dir > /dev/null &" >> $setup
-  echo "spinner \$! \"Installing additional host tools...\"" >> $setup
-  echo "[ \$? -ne 0 ] && echo \"Error(s) encountered during installation.\" && exit 1" >>$setup
-  echo "echo \"\"" >>$setup
-fi
+for file in $toolchains $file_hosttools; do
+    unpack_payload $file
+done
+share_files
+for file in $toolchains $file_hosttools; do
+    pack_payload $file
+done
 
+# add_installer <name> <file> <options>, appends a toolchain installer to the
+# INSTALLERS list of setup.sh. hosttools has to be the last one: it is the
+# only one installed without -R, and relocates the files of all toolchains.
+add_installer()
+{
+    if [ -n "$2" ]; then
+        echo "INSTALLERS+=(\"$1 ./$2 $3\")" >> $setup
+    fi
+}
 
+echo '#!/bin/bash' > $setup
+echo "DEFAULT_INSTALL_DIR=$default_dir" >> $setup
+echo "TOOLCHAIN_NAME=$toolchain_name" >> $setup
+echo "VERSION_DIR=$version_dir" >> $setup
+echo "SDK_VERSION=${sdk_version}" >> $setup
+echo "PAYLOAD_COMPRESSION=${compression}" >> $setup
+
+echo "INSTALLERS=()" >> $setup
+add_installer x86 "$file_gcc_x86" "-R -y"
+add_installer arm "$file_gcc_arm" "-R -y"
+add_installer arc "$file_gcc_arc" "-R -y"
+add_installer iamcu "$file_gcc_iamcu" "-R -y"
+add_installer mips "$file_gcc_mips" "-R -y"
+add_installer nios2 "$file_gcc_nios2" "-R -y"
+add_installer xtensa "$file_gcc_xtensa" "-R -y"
+add_installer riscv32 "$file_gcc_riscv32" "-R -y"
+add_installer hosttools "$file_hosttools" "-y"
+
+cat template_dir >>$setup
+cp dedup_sdk.py make_pch.sh toolchains/
+
+echo "" >>$setup
+echo "install_toolchains" >>$setup
+echo "" >>$setup
+echo "make_pch" >>$setup
+echo "" >>$setup
+echo "dedup_sdk" >>$setup
 echo "" >>$setup
 echo "do_cleanup"  >>$setup
 echo "" >>$setup
@@ -181,4 +377,6 @@ echo "" >>$setup
 echo "echo \"Success installing SDK. SDK is ready to be used.\"" >>$setup
 chmod 777 $setup
 
-makeself toolchains/ $toolchain_name  "SDK for Zephyr" ./setup.sh
+# The toolchain installers are compressed already, don't compress them
+# again so that setup.sh only has to decompress the toolchains it installs.
+makeself --nocomp toolchains/ $toolchain_name  "SDK for Zephyr" ./setup.sh
@@ -27,6 +27,9 @@ TOOLCHAINS="${META_ZEPHYR_SDK_SOURCE}/scripts/toolchains"
 META_DOWNLOADS=${META_DOWNLOADS:-"$META_POKY_SOURCE/downloads"}
 META_SSTATE=${SSTATE_LOCATION:-"$META_POKY_SOURCE/sstate"}
 
+# Tasks restored from SSTATE_DIR by their _setscene variant
+SSTATE_TASKS="do_populate_sysroot do_populate_lic do_packagedata do_package do_package_qa do_package_write_ipk do_deploy"
+
 if [ ! -d $META_ZEPHYR_SDK_SOURCE ] ; then
 	echo "ERROR: could not find $META_ZEPHYR_SDK_SOURCE"
 	exit 1
@@ -45,7 +48,11 @@ export DL_DIR=$META_DOWNLOADS
 if [ ! -d $TOOLCHAINS ] ; then
 	mkdir -p $TOOLCHAINS
 fi
-rm -rf $TOOLCHAINS/*
+# The parallel driver in meta-zephyr-sdk-build.sh cleans the toolchains
+# folder once and sets CLEAN_TOOLCHAINS=0 for the per-arch builds.
+if [ "${CLEAN_TOOLCHAINS:-1}" = "1" ] ; then
+	rm -rf $TOOLCHAINS/*
+fi
 
 # setconf_var, i.e. "MACHINE","qemuarm",$localconf
 setconf_var()
@@ -90,6 +97,101 @@ newbuild()
 	setconf_var "DL_DIR" "$META_DOWNLOADS" $localconf
 	setconf_var "SDKMACHINE" "x86_64" $localconf
 	setconf_var "DISTRO" "zephyr-sdk" $localconf
+
+	# Per-build CPU budget, set by the parallel driver
+	if [ -n "$SDK_BB_NUMBER_THREADS" ] ; then
+		setconf_var "BB_NUMBER_THREADS" "$SDK_BB_NUMBER_THREADS" $localconf
+	fi
+	if [ -n "$SDK_PARALLEL_MAKE" ] ; then
+		setconf_var "PARALLEL_MAKE" "-j $SDK_PARALLEL_MAKE" $localconf
+	fi
+
+	# Per-task timing for scripts/buildstats-report.py
+	if [ "$SDK_BUILDSTATS" = "1" ] ; then
+		setconf_var "INHERIT_append" " buildstats" $localconf
+	fi
+}
+
+# Hash of everything that feeds the bitbake build: this layer's classes,
+# recipes and configuration, the poky commit and the patches applied to it,
+# and the build's own local.conf/bblayers.conf. Must be run from the build
+# folder.
+build_hash()
+{
+	(
+		cd $META_ZEPHYR_SDK_SOURCE
+		find $(ls -d classes conf files patches recipes* 2> /dev/null) -type f -print0 | \
+			sort -z | xargs -0 sha256sum
+		git -C $META_POKY_SOURCE rev-parse HEAD
+	)
+	sha256sum conf/local.conf conf/bblayers.conf
+}
+
+# sstate_report <tmpdir>... <since>
+# Counts, per sstate task, the setscene runs (hits) and the real runs
+# (misses) whose task logs are newer than the file <since>.
+sstate_report()
+{
+	local since=${@: -1}
+	local tmpdirs=${@:1:$#-1}
+
+	header "sstate hits/misses"
+	for tmpdir in $tmpdirs; do
+		find $tmpdir/work -path '*/temp/log.do_*' -type f -newer $since -printf '%f\n' 2>/dev/null
+	done | sed -n 's/^log\.\(do_[a-z0-9_]*\)\.[0-9]*$/\1/p' | awk -v tasks="$SSTATE_TASKS" '
+		BEGIN { split(tasks, t); for (i in t) sstate[t[i]] = 1 }
+		{ if (sub(/_setscene$/, "")) hit[$0]++; else if ($0 in sstate) miss[$0]++ }
+		END {
+			printf "    %-24s %8s %8s\n", "task", "hits", "misses"
+			for (i = 1; i in t; i++) {
+				if (!(t[i] in hit) && !(t[i] in miss)) continue
+				printf "    %-24s %8d %8d\n", t[i], hit[t[i]], miss[t[i]]
+				nhit += hit[t[i]]; nmiss += miss[t[i]]
+			}
+			printf "    %-24s %8d %8d\n", "total", nhit, nmiss
+		}'
+}
+
+# run_bitbake <tmpdirs> <target>...
+# Builds <target>s and copies the SDK installers deployed in <tmpdirs> to
+# $TOOLCHAINS. The targets are cleaned first, unless SDK_INCREMENTAL=1: then
+# they are rebuilt on top of SSTATE_DIR, and bitbake isn't run at all if
+# build_hash() is the same as for the last successful build.
+run_bitbake()
+{
+	local tmpdirs=$1
+	local since=conf/zephyr-sdk-build.start
+	local stamp=conf/zephyr-sdk-build.hash
+	local hash
+	local status
+	shift
+
+	if [ "$SDK_INCREMENTAL" = "1" ]; then
+		hash=$(build_hash | sha256sum | cut -d' ' -f1)
+		if [ "$(cat $stamp 2>/dev/null)" = "$hash" ] && \
+		   ls $(for t in $tmpdirs; do echo $t/deploy/sdk/*.sh; done) > /dev/null 2>&1; then
+			echo "No changes since the last build of $*"
+			status=0
+		fi
+		rm -f $stamp
+	fi
+
+	if [ -z "$status" ]; then
+		for t in $tmpdirs; do rm -f $t/deploy/sdk/*.sh; done
+		if [ "$SDK_INCREMENTAL" != "1" ]; then
+			bitbake "$@" -c clean  > /dev/null
+		fi
+		touch $since
+		bitbake "$@"
+		status=$?
+		sstate_report $tmpdirs $since
+		[ $status -ne 0 ] && echo "Error(s) encountered during bitbake." && return 1
+	fi
+	[ -n "$hash" ] && echo $hash > $stamp
+
+	for t in $tmpdirs; do
+		cp $t/deploy/sdk/*.sh $TOOLCHAINS || return 1
+	done
 }
 
 
@@ -97,11 +199,7 @@ if [ "$1" = "tools" ]; then
 header "Building Zephyr host tools..."
 newbuild build-zephyr-tools  > /dev/null
 setconf_var "MACHINE" "qemux86" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake hosttools-tarball -c clean  > /dev/null
-bitbake hosttools-tarball
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
+run_bitbake ./tmp hosttools-tarball
 [ $? -ne 0 ] && exit 1
 echo "Building additional host tools...done"
 fi
@@ -113,11 +211,7 @@ newbuild build-zephyr-xtensa  > /dev/null
 setconf_var "MACHINE" "xtensa" $localconf
 setconf_var "TCLIBC" "baremetal" $localconf
 setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib xtensa-hal-staticdev" $localconf
-rm -f ./tmp/deploy/sdk/*.sh 
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain 
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
+run_bitbake ./tmp meta-toolchain
 [ $? -ne 0 ] && exit 1
 header "Building Xtensa toolchain...done"
 fi
@@ -129,11 +223,7 @@ newbuild build-zephyr-riscv32  > /dev/null
 setconf_var "MACHINE" "riscv32" $localconf
 setconf_var "TCLIBC" "baremetal" $localconf
 setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh 
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain 
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
+run_bitbake ./tmp meta-toolchain
 [ $? -ne 0 ] && exit 1
 header "Building riscv32 toolchain...done"
 fi
@@ -145,11 +235,7 @@ newbuild build-zephyr-nios2  > /dev/null
 setconf_var "MACHINE" "nios2" $localconf
 setconf_var "TCLIBC" "baremetal" $localconf
 setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
+run_bitbake ./tmp meta-toolchain
 [ $? -ne 0 ] && exit 1
 header "Building Nios2 toolchain...done"
 fi
@@ -162,11 +248,7 @@ setconf_var "MACHINE" "qemuarm" $localconf
 setconf_var "TCLIBC" "baremetal" $localconf
 setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
 setconf_var "TUNE_FEATURES" "armv7m cortexm3" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
+run_bitbake ./tmp meta-toolchain
 [ $? -ne 0 ] && exit 1
 header "Building ARM toolchain...done"
 fi
@@ -178,11 +260,7 @@ newbuild build-zephyr-x86 > /dev/null
 setconf_var "MACHINE" "qemux86" $localconf
 setconf_var "TCLIBC" "baremetal" $localconf
 setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
+run_bitbake ./tmp meta-toolchain
 [ $? -ne 0 ] && exit 1
 header "Building x86 toolchain...done"
 fi
@@ -194,11 +272,7 @@ newbuild build-zephyr-mips  > /dev/null
 setconf_var "MACHINE" "qemumips" $localconf
 setconf_var "TCLIBC" "baremetal" $localconf
 setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
+run_bitbake ./tmp meta-toolchain
 [ $? -ne 0 ] && exit 1
 header "Building MIPS toolchain...done"
 fi
@@ -210,11 +284,7 @@ newbuild build-zephyr-arc  > /dev/null
 setconf_var "MACHINE" "arc" $localconf
 setconf_var "TCLIBC" "baremetal" $localconf
 setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
+run_bitbake ./tmp meta-toolchain
 [ $? -ne 0 ] && exit 1
 header "Building ARC toolchain...done"
 fi
@@ -226,11 +296,38 @@ newbuild build-zephyr-iamcu  > /dev/null
 setconf_var "MACHINE" "iamcu" $localconf
 setconf_var "TCLIBC" "baremetal" $localconf
 setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
+run_bitbake ./tmp meta-toolchain
 [ $? -ne 0 ] && exit 1
 header "Building IAMCU toolchain...done"
 fi
+
+if [ "$1" = "multiconfig" ]; then
+# Build every toolchain from a single bitbake invocation, see
+# conf/multiconfig/<target>.conf. Recipes are parsed once and all targets
+# but xtensa share ./tmp, so their native/nativesdk dependencies are only
+# built once. xtensa patches gcc-source and binutils-crosssdk, which are
+# shared between targets, and builds in ./tmp-xtensa.
+header "Building Zephyr toolchains (multiconfig)..."
+newbuild build-zephyr-multiconfig  > /dev/null
+setconf_var "MACHINE" "qemux86" $localconf
+mc_list=""
+mc_tmpdirs=""
+mc_targets=""
+for target in ${SDK_TARGETS:-"tools xtensa riscv32 nios2 arm x86 mips arc iamcu"}; do
+	mc_list="$mc_list $target"
+	if [ "$target" = "xtensa" ]; then
+		mc_tmpdirs="$mc_tmpdirs ./tmp-xtensa"
+	elif [[ " $mc_tmpdirs " != *" ./tmp "* ]]; then
+		mc_tmpdirs="$mc_tmpdirs ./tmp"
+	fi
+	if [ "$target" = "tools" ]; then
+		mc_targets="$mc_targets multiconfig:$target:hosttools-tarball"
+	else
+		mc_targets="$mc_targets multiconfig:$target:meta-toolchain"
+	fi
+done
+setconf_var "BBMULTICONFIG" "$mc_list" $localconf
+run_bitbake "$mc_tmpdirs" $mc_targets
+[ $? -ne 0 ] && exit 1
+header "Building Zephyr toolchains (multiconfig)...done"
+fi
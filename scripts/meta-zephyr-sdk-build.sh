@@ -47,14 +47,104 @@ if [ ! -d $TOOLCHAINS ] ; then
 fi
 rm -rf $TOOLCHAINS/*
 
-# setconf_var, i.e. "MACHINE","qemuarm",$localconf
-setconf_var()
+SDK_TARGETS=${SDK_TARGETS:-"tools xtensa riscv32 nios2 arm x86 mips arc iamcu"}
+BUILD_SPLIT=$META_ZEPHYR_SDK_SOURCE/scripts/meta-zephyr-sdk-build-split.sh
+BUILD_LOGS=${BUILD_LOGS:-"$META_POKY_SOURCE/logs"}
+parallel=0
+multiconfig=0
+buildstats=0
+bench=0
+
+usage ()
 {
-	sed -i "/^$1=/d" $3
-	echo "$1=\"$2\"" >> $3
-	echo $1="$2"
+	cat << EOF
+  Usage : $(basename $0) < -- options >
+
+
+Options:
+  -h
+        Display this help and exit.
+
+  -j
+        Build all targets at once. The builds share DL_DIR and SSTATE_DIR,
+        and each one gets an equal share of the host cores as its
+        BB_NUMBER_THREADS and PARALLEL_MAKE. Build output is written to
+        \$BUILD_LOGS/<target>.log.
+
+  -i
+        Incremental build: don't clean the targets before building them, so
+        everything that didn't change is restored from SSTATE_DIR. A target
+        isn't rebuilt at all when none of the recipes, configuration and
+        patches of this layer changed since its last successful build.
+
+  -m
+        Build all targets with a single multiconfig bitbake invocation in
+        build-zephyr-multiconfig, see conf/multiconfig/.
+
+  -b
+        Install the new SDK and run scripts/run-libc-bench.sh with it, the
+        results are written to \$BUILD_LOGS/libc-bench.{csv,json}. Needs
+        ZEPHYR_BASE, and compares with BENCH_BASELINE when it is set.
+
+  -s
+        Collect buildstats in all builds and report the slowest tasks of the
+        SDK build. All tasks are also written to \$BUILD_LOGS/buildstats.json.
+
+Environment:
+  SDK_TARGETS   Targets to build (default: "tools xtensa riscv32 nios2 arm
+                x86 mips arc iamcu").
+  SDK_CPUS      Cores shared between the parallel builds (default: nproc).
+  BUILD_LOGS    Log folder for -j and -s (default: \$POKY_SOURCE/logs).
+  BENCH_BASELINE
+                Results of a previous -b run to check for regressions.
+  SDK_COMPRESSION
+                Compression of the toolchain payloads, xz or zstd (default:
+                xz).
+
+EOF
 }
 
+while [ "$1" != "" ]; do
+	case $1 in
+		-h )
+			usage
+			exit 0
+			;;
+		-j )
+			parallel=1
+			;;
+		-i )
+			export SDK_INCREMENTAL=1
+			;;
+		-m )
+			multiconfig=1
+			;;
+		-b )
+			bench=1
+			;;
+		-s )
+			buildstats=1
+			export SDK_BUILDSTATS=1
+			;;
+		* )
+			echo "Error: Invalid argument \"$1\""
+			usage
+			exit 1
+			;;
+	esac
+	shift
+done
+
+if [ $bench -eq 1 -a -z "$ZEPHYR_BASE" ] ; then
+	echo "Error: -b needs ZEPHYR_BASE to point to a Zephyr tree"
+	exit 1
+fi
+
+if [ $parallel -eq 1 -a $multiconfig -eq 1 ] ; then
+	echo "Error: -j and -m can't be used together"
+	exit 1
+fi
+
 header ()
 {
 echo ""
@@ -63,167 +153,127 @@ echo "    $1"
 echo "########################################################################"
 }
 
-newbuild()
+# elapsed <seconds>, i.e. 3725 -> "1h02m05s"
+elapsed ()
 {
-	cd $META_POKY_SOURCE
-	source oe-init-build-env $1
-
-	# Create bblayers.conf
-	bblayers=conf/bblayers.conf
-
-	echo "# LAYER_CONF_VERSION is increased each time build/conf/bblayers.conf" > $bblayers
-	echo "# changes incompatibly" >> $bblayers
-	echo "LCONF_VERSION = \"6\"" >> $bblayers
-	echo "" >> $bblayers
-	echo "BBPATH = \"\${TOPDIR}\"" >> $bblayers
-	echo "BBFILES ?= \"\"" >> $bblayers
-	echo "BBLAYERS ?= \" \\" >> $bblayers
-	echo "  $META_POKY_SOURCE/meta \\" >> $bblayers
-	echo "  $META_POKY_SOURCE/meta-yocto \\" >> $bblayers
-	echo "  $META_POKY_SOURCE/meta-yocto-bsp \\" >> $bblayers
-	echo "  $META_ZEPHYR_SDK_SOURCE \\" >> $bblayers
-	echo "  \" " >> $bblayers
-
-	# Common values for all builds
-	localconf=conf/local.conf
-	setconf_var "SSTATE_DIR" "$META_SSTATE" $localconf
-	setconf_var "DL_DIR" "$META_DOWNLOADS" $localconf
-	setconf_var "SDKMACHINE" "x86_64" $localconf
-	setconf_var "DISTRO" "zephyr-sdk" $localconf
+	printf "%dh%02dm%02ds" $(($1 / 3600)) $(($1 % 3600 / 60)) $(($1 % 60))
 }
 
-##############################################################################
-# 32 bit build
-##############################################################################
-header "Building Zephyr host tools..."
-newbuild build-zephyr-tools  > /dev/null
-setconf_var "MACHINE" "qemux86" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake hosttools-tarball -c clean  > /dev/null
-bitbake hosttools-tarball
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
-[ $? -ne 0 ] && exit 1
-echo "Building additional host tools...done"
-
-# build Xtensa toolchain
-header "Building Xtensa toolchain..."
-newbuild build-zephyr-xtensa  > /dev/null
-setconf_var "MACHINE" "xtensa" $localconf
-setconf_var "TCLIBC" "baremetal" $localconf
-setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib xtensa-hal-staticdev" $localconf
-rm -f ./tmp/deploy/sdk/*.sh 
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain 
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
-[ $? -ne 0 ] && exit 1
-header "Building Xtensa toolchain...done"
-
-# build RISC-V toolchain
-header "Building riscv32 toolchain..."
-newbuild build-zephyr-riscv32  > /dev/null
-setconf_var "MACHINE" "riscv32" $localconf
-setconf_var "TCLIBC" "baremetal" $localconf
-setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh 
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain 
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
-[ $? -ne 0 ] && exit 1
-header "Building riscv32 toolchain...done"
-# build NIOS2 toolchain
-header "Building Nios2 toolchain..."
-newbuild build-zephyr-nios2  > /dev/null
-setconf_var "MACHINE" "nios2" $localconf
-setconf_var "TCLIBC" "baremetal" $localconf
-setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
-[ $? -ne 0 ] && exit 1
-header "Building Nios2 toolchain...done"
-
-# build ARM toolchain
-header "Building ARM toolchain..."
-newbuild build-zephyr-arm  > /dev/null
-setconf_var "MACHINE" "qemuarm" $localconf
-setconf_var "TCLIBC" "baremetal" $localconf
-setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-setconf_var "TUNE_FEATURES" "armv7m cortexm3" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
-[ $? -ne 0 ] && exit 1
-header "Building ARM toolchain...done"
-
-# build x86 toolchain
-header "Building x86 toolchain..."
-newbuild build-zephyr-x86 > /dev/null
-setconf_var "MACHINE" "qemux86" $localconf
-setconf_var "TCLIBC" "baremetal" $localconf
-setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
-[ $? -ne 0 ] && exit 1
-header "Building x86 toolchain...done"
-
-#  build MIPS toolchain
-header "Building MIPS toolchain..."
-newbuild build-zephyr-mips  > /dev/null
-setconf_var "MACHINE" "qemumips" $localconf
-setconf_var "TCLIBC" "baremetal" $localconf
-setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
-[ $? -ne 0 ] && exit 1
-header "Building MIPS toolchain...done"
-
-# build ARC toolchain...
-header "Building ARC toolchain..."
-newbuild build-zephyr-arc  > /dev/null
-setconf_var "MACHINE" "arc" $localconf
-setconf_var "TCLIBC" "baremetal" $localconf
-setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
-[ $? -ne 0 ] && exit 1
-header "Building ARC toolchain...done"
-
-#  build IAMCU toolchain
-header "Building IAMCU  toolchain..."
-newbuild build-zephyr-iamcu  > /dev/null
-setconf_var "MACHINE" "iamcu" $localconf
-setconf_var "TCLIBC" "baremetal" $localconf
-setconf_var "TOOLCHAIN_TARGET_TASK_append" " newlib" $localconf
-rm -f ./tmp/deploy/sdk/*.sh
-bitbake meta-toolchain -c clean  > /dev/null
-bitbake meta-toolchain
-[ $? -ne 0 ] && echo "Error(s) encountered during bitbake." && exit 1
-cp ./tmp/deploy/sdk/*.sh $TOOLCHAINS
-[ $? -ne 0 ] && exit 1
-header "Building IAMCU toolchain...done"
+# Each target is built by meta-zephyr-sdk-build-split.sh in its own
+# build-zephyr-<target> folder. The toolchains folder was cleaned above and
+# collects the output of all of them, so the split script must not wipe it.
+export CLEAN_TOOLCHAINS=0
+export SDK_SOURCE=$META_ZEPHYR_SDK_SOURCE
+export POKY_SOURCE=$META_POKY_SOURCE
+export META_DOWNLOADS
+export SSTATE_LOCATION=$META_SSTATE
+
+# A multiconfig build is a single "multiconfig" target of the split script
+if [ $multiconfig -eq 1 ] ; then
+	export SDK_TARGETS
+	build_targets="multiconfig"
+else
+	build_targets=$SDK_TARGETS
+fi
+
+declare -A build_status
+declare -A build_time
+declare -A build_pid
+start_all=$(date +%s)
+
+if [ $parallel -eq 0 ] ; then
+	for target in $build_targets ; do
+		start=$(date +%s)
+		$BUILD_SPLIT $target
+		build_status[$target]=$?
+		build_time[$target]=$(($(date +%s) - start))
+		[ ${build_status[$target]} -ne 0 ] && break
+	done
+else
+	ntargets=$(echo $SDK_TARGETS | wc -w)
+	cpus=${SDK_CPUS:-$(nproc)}
+	budget=$((cpus / ntargets))
+	[ $budget -lt 1 ] && budget=1
+	export SDK_BB_NUMBER_THREADS=$budget
+	export SDK_PARALLEL_MAKE=$budget
+
+	mkdir -p $BUILD_LOGS
+	header "Building $ntargets targets, $budget of $cpus cores each..."
+	for target in $SDK_TARGETS ; do
+		(
+			start=$(date +%s)
+			$BUILD_SPLIT $target > $BUILD_LOGS/$target.log 2>&1
+			status=$?
+			echo "$status $(($(date +%s) - start))" > $BUILD_LOGS/$target.time
+			exit $status
+		) &
+		build_pid[$target]=$!
+		echo "Building $target... (log: $BUILD_LOGS/$target.log)"
+	done
+
+	for target in $SDK_TARGETS ; do
+		wait ${build_pid[$target]}
+		read status seconds < $BUILD_LOGS/$target.time
+		build_status[$target]=$status
+		build_time[$target]=$seconds
+		rm -f $BUILD_LOGS/$target.time
+		if [ $status -eq 0 ] ; then
+			echo "Building $target...done"
+		else
+			echo "Building $target...failed"
+		fi
+	done
+fi
+
+header "Build times"
+failed=0
+for target in $build_targets ; do
+	[ -z "${build_status[$target]}" ] && continue
+	if [ ${build_status[$target]} -eq 0 ] ; then
+		printf "    %-10s %s\n" $target $(elapsed ${build_time[$target]})
+	else
+		printf "    %-10s %s  FAILED\n" $target $(elapsed ${build_time[$target]})
+		failed=1
+	fi
+done
+printf "    %-10s %s\n" "total" $(elapsed $(($(date +%s) - start_all)))
+
+if [ $buildstats -eq 1 ] ; then
+	header "Slowest tasks"
+	mkdir -p $BUILD_LOGS
+	$META_ZEPHYR_SDK_SOURCE/scripts/buildstats-report.py \
+		--json $BUILD_LOGS/buildstats.json \
+		$(for target in $build_targets; do echo $META_POKY_SOURCE/build-zephyr-$target; done)
+fi
+
+if [ $failed -ne 0 ] ; then
+	echo "Error(s) encountered during bitbake."
+	exit 1
+fi
 
 # Pack it together ...
 
 cd $META_ZEPHYR_SDK_SOURCE/scripts
 header "Creating SDK..."
-./make_zephyr_sdk.sh
+./make_zephyr_sdk.sh -compression ${SDK_COMPRESSION:-xz}
 if [ $? -ne 0 ] ; then
 	echo "Error(s) encountered during SDK creation."
 	exit 1
 fi
+
+if [ $bench -eq 1 ] ; then
+	header "Running libc benchmarks..."
+	bench_sdk=$BUILD_LOGS/libc-bench-sdk
+	rm -rf $bench_sdk
+	./$(ls -t *-setup.run | head -1) -- -y -d $bench_sdk > /dev/null
+	if [ $? -ne 0 ] ; then
+		echo "Error(s) encountered installing the SDK for the benchmarks."
+		exit 1
+	fi
+	ZEPHYR_SDK_INSTALL_DIR=$bench_sdk BENCH_BUILD=$BUILD_LOGS/libc-bench-build \
+		./run-libc-bench.sh -o $BUILD_LOGS/libc-bench \
+		${BENCH_BASELINE:+-b $BENCH_BASELINE}
+	status=$?
+	rm -rf $bench_sdk
+	exit $status
+fi
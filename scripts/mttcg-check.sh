@@ -0,0 +1,173 @@
+#!/bin/bash
+#
+# Validates the multi-threaded TCG (MTTCG) of the SDK's QEMU: builds a set of
+# Zephyr SMP kernel tests for the SMP QEMU boards, runs each of them with one
+# host thread for all the guest CPUs (thread=single) and then several times
+# with one host thread per guest CPU (thread=multi), and reports the run times
+# and the speedup. Any build or run failure fails the check.
+#
+#   ZEPHYR_BASE=~/zephyr ZEPHYR_SDK_INSTALL_DIR=/opt/zephyr-sdk \
+#       ./mttcg-check.sh -o mttcg qemu_x86_64
+#
+
+MTTCG_BUILD=${MTTCG_BUILD:-"$PWD/mttcg-build"}
+MTTCG_TIMEOUT=${MTTCG_TIMEOUT:-300}
+MTTCG_RUNS=${MTTCG_RUNS:-3}
+MTTCG_TESTS=${MTTCG_TESTS:-"tests/kernel/smp tests/kernel/mp \
+	tests/kernel/common tests/kernel/mutex/mutex_api \
+	tests/kernel/semaphore/semaphore tests/kernel/sched/schedule_api"}
+
+# The Zephyr QEMU boards with more than one CPU
+ALL_BOARDS="qemu_x86_64"
+
+output=""
+
+usage ()
+{
+	cat << EOF
+  Usage : $(basename $0) [options] [<board>...]
+
+Options:
+  -h
+        Display this help and exit.
+
+  -o <prefix>
+        Write the results to <prefix>.csv.
+
+  -n <runs>
+        Number of thread=multi runs of each test (default: $MTTCG_RUNS).
+
+Boards default to: $ALL_BOARDS
+
+Environment:
+  MTTCG_TESTS    Tests to run, relative to ZEPHYR_BASE.
+  MTTCG_TIMEOUT  Timeout of a single run, in seconds (default: $MTTCG_TIMEOUT).
+
+EOF
+}
+
+while [ "$1" != "" ]; do
+	case $1 in
+		-h )
+			usage
+			exit 0
+			;;
+		-o )
+			shift
+			output=$1
+			;;
+		-n )
+			shift
+			MTTCG_RUNS=$1
+			;;
+		-* )
+			echo "Error: Invalid argument \"$1\""
+			usage
+			exit 1
+			;;
+		* )
+			break
+			;;
+	esac
+	shift
+done
+
+if [ -z "$ZEPHYR_BASE" -o ! -d "$ZEPHYR_BASE" ]; then
+	echo "ERROR: ZEPHYR_BASE must point to a Zephyr tree"
+	exit 1
+fi
+export ZEPHYR_TOOLCHAIN_VARIANT=zephyr
+
+boards=${@:-$ALL_BOARDS}
+
+# run_test <builddir> <log>, prints the run time in seconds, fails if the
+# test did not pass
+run_test ()
+{
+	local out=$1-$2.out
+	local start end
+
+	start=$(date +%s.%N)
+	(cd $1 && timeout $MTTCG_TIMEOUT ninja run) > $out 2>&1 &
+	pid=$!
+	while kill -0 $pid 2> /dev/null &&
+	      ! grep -q "PROJECT EXECUTION \(SUCCESSFUL\|FAILED\)" $out; do
+		sleep 0.1
+	done
+	end=$(date +%s.%N)
+	kill $pid 2> /dev/null
+	wait $pid
+
+	grep -q "PROJECT EXECUTION SUCCESSFUL" $out || return 1
+	echo "$end - $start" | bc
+}
+
+mkdir -p $MTTCG_BUILD
+results=$MTTCG_BUILD/results.csv
+echo "board,test,thread,run,seconds,status" > $results
+failed=0
+
+for board in $boards; do
+	echo ""
+	echo "$board"
+	printf "    %-36s%10s%10s%10s\n" "" single multi speedup
+
+	for test in $MTTCG_TESTS; do
+		dir=$MTTCG_BUILD/$board-$(echo ${test#tests/} | tr / _)
+
+		rm -rf $dir && mkdir -p $dir
+		for thread in single multi; do
+			mkdir -p $dir/$thread
+			# Zephyr splits QEMU_EXTRA_FLAGS from the environment into
+			# arguments, -DQEMU_EXTRA_FLAGS would be a single one
+			(cd $dir/$thread && \
+			 QEMU_EXTRA_FLAGS="-accel tcg,thread=$thread" cmake -GNinja \
+				-DBOARD=$board $ZEPHYR_BASE/$test && ninja) > $dir/$thread.log 2>&1
+			if [ $? -ne 0 ]; then
+				echo "ERROR: Building $test for $board failed, see $dir/$thread.log" 1>&2
+				echo "$board,$test,$thread,,,build-fail" >> $results
+				failed=1
+				continue 2
+			fi
+		done
+
+		single=$(run_test $dir/single single)
+		if [ $? -ne 0 ]; then
+			echo "ERROR: $test fails on $board with thread=single, see $dir/single-single.out" 1>&2
+			echo "$board,$test,single,1,,fail" >> $results
+			failed=1
+			continue
+		fi
+		echo "$board,$test,single,1,$single,pass" >> $results
+
+		# Races in the TCG front end show up as intermittent failures, so
+		# thread=multi is run several times and the best time is reported
+		best=""
+		for run in $(seq $MTTCG_RUNS); do
+			multi=$(run_test $dir/multi multi-$run)
+			if [ $? -ne 0 ]; then
+				echo "ERROR: $test fails on $board with thread=multi, see $dir/multi-multi-$run.out" 1>&2
+				echo "$board,$test,multi,$run,,fail" >> $results
+				failed=1
+				continue
+			fi
+			echo "$board,$test,multi,$run,$multi,pass" >> $results
+			if [ -z "$best" ] || [ $(echo "$multi < $best" | bc) -eq 1 ]; then
+				best=$multi
+			fi
+		done
+
+		if [ -n "$best" ]; then
+			printf "    %-36s%10.2f%10.2f%9.2fx\n" $test $single $best \
+				$(echo "$single / $best" | bc -l)
+		else
+			printf "    %-36s%10.2f%10s%10s\n" $test $single FAIL -
+		fi
+	done
+done
+
+if [ -n "$output" ]; then
+	cp $results $output.csv
+fi
+
+exit $failed
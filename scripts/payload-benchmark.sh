@@ -0,0 +1,103 @@
+#!/bin/bash
+#
+# Compares the size and the extraction time of the toolchain payloads with
+# the compression formats supported by make_zephyr_sdk.sh, i.e.
+#
+#   ./payload-benchmark.sh toolchains/*.sh
+#
+# Each installer payload is unpacked once and then compressed and extracted
+# again with every format. The extraction includes tar writing the files to
+# a scratch folder, as setup.sh does.
+#
+
+FORMATS=${FORMATS:-"xz xz-block zstd-19 zstd-19-long zstd-10"}
+SCRATCH=$(mktemp -d)
+trap "rm -rf $SCRATCH" EXIT
+
+usage ()
+{
+	cat << EOF
+  Usage : $(basename $0) <installer.sh> [<installer.sh>...]
+
+Environment:
+  FORMATS   Formats to compare (default: "$FORMATS").
+
+EOF
+}
+
+# compress <format>, from stdin to stdout
+compress ()
+{
+	case $1 in
+		xz )           xz -T1 -9 ;;
+		xz-block )     xz -T0 -9 --block-size=32MiB ;;
+		zstd-19 )      zstd -q -T0 -19 ;;
+		zstd-19-long ) zstd -q -T0 -19 --long=27 ;;
+		zstd-10 )      zstd -q -T0 -10 ;;
+	esac
+}
+
+# decompressor <format>, the program tar uses to extract the payload
+decompressor ()
+{
+	case $1 in
+		xz* )         echo "xz -T0" ;;
+		zstd-*-long ) echo "zstd --long=27" ;;
+		zstd* )       echo "zstd" ;;
+	esac
+}
+
+# now_ms, wall clock in milliseconds
+now_ms ()
+{
+	echo $(($(date +%s%N) / 1000000))
+}
+
+if [ $# -eq 0 -o "$1" = "-h" ]; then
+	usage
+	exit 0
+fi
+
+printf "%-24s %-14s %10s %8s %10s %10s\n" \
+	"arch" "format" "size(KB)" "ratio" "pack(s)" "extract(s)"
+
+for installer in "$@"; do
+	# <...>-meta-toolchain-<tune>-<machine>-toolchain-<version>.sh, and
+	# <...>-hosttools-standalone-<version>.sh
+	arch=$(basename $installer .sh | \
+		sed -n 's/.*-meta-toolchain-\(.*\)-toolchain-.*/\1/p; s/.*-\(hosttools\)-standalone-.*/\1/p')
+	[ -z "$arch" ] && arch=$(basename $installer .sh)
+	line=$(grep -na -m1 "^MARKER:$" $installer | cut -d':' -f1)
+	if [ -z "$line" ]; then
+		echo "Warning: $installer is not a toolchain installer, skipped" 1>&2
+		continue
+	fi
+
+	# Unpack the payload, whichever format it was built with
+	tail -n +$((line + 1)) $installer > $SCRATCH/payload
+	if xz -t $SCRATCH/payload 2> /dev/null; then
+		xz -d -T0 < $SCRATCH/payload > $SCRATCH/payload.tar
+	else
+		zstd -q -d --long=27 < $SCRATCH/payload > $SCRATCH/payload.tar
+	fi
+	tar_size=$(stat -c %s $SCRATCH/payload.tar)
+
+	for format in $FORMATS; do
+		start=$(now_ms)
+		compress $format < $SCRATCH/payload.tar > $SCRATCH/payload.$format
+		pack=$(($(now_ms) - start))
+		size=$(stat -c %s $SCRATCH/payload.$format)
+
+		rm -rf $SCRATCH/out && mkdir $SCRATCH/out
+		start=$(now_ms)
+		tar mx -I "$(decompressor $format)" -C $SCRATCH/out < $SCRATCH/payload.$format
+		extract=$(($(now_ms) - start))
+
+		awk -v a=$arch -v f=$format -v s=$size -v t=$tar_size \
+		    -v p=$pack -v e=$extract 'BEGIN {
+			printf "%-24s %-14s %10d %8.3f %10.2f %10.2f\n",
+			       a, f, s / 1024, s / t, p / 1000, e / 1000 }'
+		rm -f $SCRATCH/payload.$format
+	done
+	rm -rf $SCRATCH/out $SCRATCH/payload $SCRATCH/payload.tar
+done
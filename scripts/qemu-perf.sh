@@ -0,0 +1,170 @@
+#!/bin/bash
+#
+# Measures the startup time and guest MIPS of the SDK's QEMU on each target,
+# to compare an optimized build (QEMU_OPTIMIZE in the qemu recipe) with a
+# default one. The images are Zephyr tests built for the QEMU boards. They
+# run with instruction counting and up to ztest's end_report, so the guest
+# executes the same instructions on every run and with every build.
+#
+#   ZEPHYR_SDK_INSTALL_DIR=/opt/zephyr-sdk ./qemu-perf.sh \
+#       -b /opt/zephyr-sdk-default -o qemu-perf \
+#       qemu_x86=x86/zephyr/zephyr.elf qemu_cortex_m3=arm/zephyr/zephyr.elf
+#
+# -T trains an SDK built with QEMU_OPTIMIZE = "pgo-generate": it runs all
+# the images of the given folders with that QEMU and writes the profile to
+# use as QEMU_PGO_PROFILE.
+#
+#   ZEPHYR_SDK_INSTALL_DIR=/opt/zephyr-sdk-pgo ./qemu-perf.sh \
+#       -T ~/qemu-profile sanity-out/qemu_x86 sanity-out/qemu_cortex_m3
+#
+
+QEMU_PERF_RUNS=${QEMU_PERF_RUNS:-5}
+RUNNER=$(readlink -f $(dirname $0)/../recipes-devtools/qemu/files/zephyr-qemu-runner)
+
+output=""
+baseline=""
+training=""
+
+usage ()
+{
+	cat << EOF
+  Usage : $(basename $0) [options] <board>=<image>...
+          $(basename $0) -T <profile> <sanitycheck folder>...
+
+Options:
+  -h
+        Display this help and exit.
+
+  -o <prefix>
+        Write the results to <prefix>.csv.
+
+  -b <sdk>
+        Also measure the QEMU of the SDK installed there, and compare.
+
+  -T <profile>
+        Run the images with the instrumented QEMU of a pgo-generate build
+        and write the profile there.
+
+Environment:
+  ZEPHYR_SDK_INSTALL_DIR  SDK to measure (or train).
+  QEMU_PERF_RUNS          Timed runs of each image, the best one counts
+                          (default: $QEMU_PERF_RUNS).
+
+EOF
+}
+
+while [ "$1" != "" ]; do
+	case $1 in
+		-h )
+			usage
+			exit 0
+			;;
+		-o )
+			shift
+			output=$1
+			;;
+		-b )
+			shift
+			baseline=$1
+			;;
+		-T )
+			shift
+			training=$1
+			;;
+		-* )
+			echo "Error: Invalid argument \"$1\""
+			usage
+			exit 1
+			;;
+		* )
+			break
+			;;
+	esac
+	shift
+done
+
+if [ -z "$ZEPHYR_SDK_INSTALL_DIR" -o ! -d "$ZEPHYR_SDK_INSTALL_DIR" ]; then
+	echo "ERROR: ZEPHYR_SDK_INSTALL_DIR must point to an installed SDK"
+	exit 1
+fi
+
+# qemu_dir <sdk>, where the QEMU binaries of an installed SDK are
+qemu_dir ()
+{
+	ls -d $1/sysroots/*-pokysdk-linux/usr/bin 2> /dev/null | head -1
+}
+
+if [ -n "$training" ]; then
+	dir=$(qemu_dir $ZEPHYR_SDK_INSTALL_DIR)
+	strip=$dir/../share/zephyr-qemu/pgo-strip
+	if [ ! -f $strip ]; then
+		echo "ERROR: The QEMU of $ZEPHYR_SDK_INSTALL_DIR isn't a pgo-generate build"
+		exit 1
+	fi
+
+	# QEMU writes its profile when it exits, the runner terminates it
+	mkdir -p $training
+	export GCOV_PREFIX=$(readlink -f $training)
+	export GCOV_PREFIX_STRIP=$(cat $strip)
+	for folder in "$@"; do
+		board=$(basename $folder)
+		images=$(find $folder -path "*/zephyr/zephyr.elf" | sort)
+		[ -n "$images" ] || continue
+		ZEPHYR_QEMU_DIR=$dir $RUNNER batch -b $board $images
+	done
+	echo ""
+	echo "Profile written to $training, build with:"
+	echo "    QEMU_OPTIMIZE = \"pgo\""
+	echo "    QEMU_PGO_PROFILE = \"$GCOV_PREFIX\""
+	exit 0
+fi
+
+results=$(mktemp)
+trap "rm -f $results $results.*" EXIT
+
+for build in baseline current; do
+	if [ $build = baseline ]; then
+		[ -n "$baseline" ] || continue
+		dir=$(qemu_dir $baseline)
+	else
+		dir=$(qemu_dir $ZEPHYR_SDK_INSTALL_DIR)
+	fi
+	for target in "$@"; do
+		ZEPHYR_QEMU_DIR=$dir $RUNNER speed -n $QEMU_PERF_RUNS \
+			-o $results.$build -b ${target%%=*} ${target#*=} ||
+			echo "ERROR: Measuring $target with $dir failed" 1>&2
+	done
+done
+
+python3 - $results $baseline << 'PYEOF'
+import csv, os, sys
+results = sys.argv[1]
+rows = {}
+for build in ('baseline', 'current'):
+    path = results + '.' + build
+    if os.path.exists(path):
+        for r in csv.DictReader(open(path)):
+            rows.setdefault((r['board'], r['image']), {})[build] = r
+
+out = open(results, 'w')
+out.write('board,image,build,startup,mips\n')
+print('')
+print('    %-16s%22s%22s' % ('', 'startup (s)', 'guest MIPS'))
+for (board, image), builds in sorted(rows.items()):
+    cur, base = builds.get('current'), builds.get('baseline')
+    for build, r in sorted(builds.items()):
+        out.write('%s,%s,%s,%s,%s\n' %
+                  (board, image, build, r['startup'], r['mips']))
+    if cur and base:
+        print('    %-16s%9.3f ->%7.3f%4s%8.1f ->%8.1f (%+.0f%%)' %
+              (board, float(base['startup']), float(cur['startup']), '',
+               float(base['mips']), float(cur['mips']),
+               100.0 * (float(cur['mips']) / float(base['mips']) - 1)))
+    elif cur:
+        print('    %-16s%18.3f%4s%18.1f' %
+              (board, float(cur['startup']), '', float(cur['mips'])))
+PYEOF
+
+if [ -n "$output" ]; then
+	cp $results $output.csv
+fi
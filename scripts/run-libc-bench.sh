@@ -0,0 +1,208 @@
+#!/bin/bash
+#
+# Builds scripts/libc-bench against each newlib variant of an installed SDK
+# for a set of QEMU boards, runs it under the SDK's QEMU with instruction
+# counting (so the cycle counts are deterministic) and reports the results
+# per arch, multilib and variant. The results can be compared against those
+# of a previous SDK to catch libc regressions.
+#
+#   ZEPHYR_BASE=~/zephyr ZEPHYR_SDK_INSTALL_DIR=/opt/zephyr-sdk \
+#       ./run-libc-bench.sh -o results qemu_x86 qemu_cortex_m3
+#
+
+BENCH_SOURCE=$(readlink -f $(dirname $0)/libc-bench)
+BENCH_BUILD=${BENCH_BUILD:-"$PWD/libc-bench-build"}
+BENCH_TIMEOUT=${BENCH_TIMEOUT:-120}
+BENCH_ICOUNT=${BENCH_ICOUNT:-"-icount shift=0,align=off,sleep=off"}
+VARIANTS=${VARIANTS:-"nano speed lfmalloc fpu reent"}
+
+# There is no Zephyr QEMU board for mips
+ALL_BOARDS="qemu_x86 qemu_x86_iamcu qemu_cortex_m3 qemu_nios2 qemu_xtensa qemu_riscv32"
+
+output=""
+baseline=""
+threshold=5
+
+usage ()
+{
+	cat << EOF
+  Usage : $(basename $0) [options] [<board>...]
+
+Options:
+  -h
+        Display this help and exit.
+
+  -o <prefix>
+        Write the results to <prefix>.csv and <prefix>.json.
+
+  -b <baseline.csv>
+        Compare the results with those of a previous run, and fail if a
+        benchmark got slower by more than the threshold, or a libm function
+        less accurate.
+
+  -t <percent>
+        Regression threshold for -b (default: $threshold).
+
+Boards default to: $ALL_BOARDS
+
+Environment:
+  VARIANTS      newlib variants to compare (default: "$VARIANTS").
+  BENCH_ICOUNT  QEMU instruction counting options.
+
+EOF
+}
+
+while [ "$1" != "" ]; do
+	case $1 in
+		-h )
+			usage
+			exit 0
+			;;
+		-o )
+			shift
+			output=$1
+			;;
+		-b )
+			shift
+			baseline=$1
+			;;
+		-t )
+			shift
+			threshold=$1
+			;;
+		-* )
+			echo "Error: Invalid argument \"$1\""
+			usage
+			exit 1
+			;;
+		* )
+			break
+			;;
+	esac
+	shift
+done
+
+if [ -z "$ZEPHYR_BASE" -o ! -d "$ZEPHYR_BASE" ]; then
+	echo "ERROR: ZEPHYR_BASE must point to a Zephyr tree"
+	exit 1
+fi
+export ZEPHYR_TOOLCHAIN_VARIANT=zephyr
+
+boards=${@:-$ALL_BOARDS}
+
+# multilib <builddir>, the newlib multilib folder the app was linked with
+multilib ()
+{
+	python3 - $1/compile_commands.json << 'PYEOF'
+import json, shlex, subprocess, sys
+for entry in json.load(open(sys.argv[1])):
+    if entry['file'].endswith('src/main.c'):
+        args = shlex.split(entry['command'])
+        flags = [a for a in args[1:] if a.startswith('-m')]
+        print(subprocess.check_output([args[0]] + flags +
+              ['-print-multi-directory']).decode().strip())
+        break
+PYEOF
+}
+
+# run_bench <board> <variant>, prints "<name> <cycles>" lines
+run_bench ()
+{
+	local dir=$BENCH_BUILD/$1-$2
+
+	rm -rf $dir && mkdir -p $dir
+	# Zephyr splits QEMU_EXTRA_FLAGS from the environment into arguments,
+	# -DQEMU_EXTRA_FLAGS would reach QEMU as a single one
+	(cd $dir && QEMU_EXTRA_FLAGS="$BENCH_ICOUNT" cmake -GNinja \
+		-DBOARD=$1 -DLIBC_VARIANT=$2 \
+		-DCMAKE_EXPORT_COMPILE_COMMANDS=ON $BENCH_SOURCE &&
+	 ninja) > $dir.log 2>&1
+	if [ $? -ne 0 ]; then
+		echo "ERROR: Building for $1 ($2) failed, see $dir.log" 1>&2
+		return 1
+	fi
+
+	(cd $dir && timeout $BENCH_TIMEOUT ninja run) > $dir.out 2>&1 &
+	pid=$!
+	while kill -0 $pid 2> /dev/null && ! grep -q "^BENCH done" $dir.out; do
+		sleep 1
+	done
+	kill $pid 2> /dev/null
+	wait $pid
+
+	if ! grep -q "^BENCH done" $dir.out; then
+		echo "ERROR: Running on $1 ($2) failed, see $dir.out" 1>&2
+		return 1
+	fi
+	tr -d '\r' < $dir.out | sed -n 's/^BENCH \([a-z_]*\) \([0-9]*\)$/\1 \2/p'
+	size=$(sed -n 's/^CMAKE_SIZE:[A-Z]*=//p' $dir/CMakeCache.txt)
+	echo "text_size $(${size:-size} -A $dir/zephyr/zephyr.elf | awk '$1 == ".text" { print $2 }')"
+}
+
+mkdir -p $BENCH_BUILD
+results=$BENCH_BUILD/results.csv
+echo "arch,board,multilib,variant,benchmark,cycles" > $results
+
+for board in $boards; do
+	for variant in $VARIANTS; do
+		run_bench $board $variant > $BENCH_BUILD/$board-$variant.txt || continue
+		arch=$(sed -n 's/^CONFIG_ARCH="\(.*\)"$/\1/p' $BENCH_BUILD/$board-$variant/zephyr/.config)
+		lib=$(multilib $BENCH_BUILD/$board-$variant)
+		awk -v prefix="$arch,$board,${lib:-.},$variant" \
+			'{ print prefix "," $1 "," $2 }' $BENCH_BUILD/$board-$variant.txt >> $results
+	done
+
+	echo ""
+	echo "$board"
+	python3 - $results $board $VARIANTS << 'PYEOF'
+import csv, sys
+board, variants = sys.argv[2], sys.argv[3:]
+rows = [r for r in csv.DictReader(open(sys.argv[1])) if r['board'] == board]
+table = {}
+for r in rows:
+    table.setdefault(r['benchmark'], {})[r['variant']] = int(r['cycles'])
+print('    %-18s' % '' + ''.join('%12s' % v for v in variants))
+for name, cycles in table.items():
+    print('    %-18s' % name +
+          ''.join('%12s' % cycles.get(v, '-') for v in variants))
+PYEOF
+done
+
+if [ -n "$output" ]; then
+	cp $results $output.csv
+	python3 -c "import csv, json, sys; json.dump(list(csv.DictReader(open(sys.argv[1]))), open(sys.argv[2], 'w'), indent=1)" \
+		$results $output.json
+fi
+
+if [ -n "$baseline" ]; then
+	echo ""
+	echo "Regressions of more than $threshold% against $baseline:"
+	python3 - $baseline $results $threshold << 'PYEOF'
+import csv, sys
+key = lambda r: (r['board'], r['multilib'], r['variant'], r['benchmark'])
+old = {key(r): int(r['cycles']) for r in csv.DictReader(open(sys.argv[1]))}
+threshold = float(sys.argv[3])
+failed = 0
+for r in csv.DictReader(open(sys.argv[2])):
+    before = old.get(key(r))
+    if before is None or r['benchmark'] == 'text_size':
+        continue
+    if r['benchmark'].startswith('ulp_'):
+        if int(r['cycles']) > before:
+            print('    %s %s %s %s: %d -> %s ulps' %
+                  (key(r) + (before, r['cycles'])))
+            failed = 1
+        continue
+    if not before:
+        continue
+    change = 100.0 * (int(r['cycles']) - before) / before
+    if change > threshold:
+        print('    %s %s %s %s: %d -> %s (+%.1f%%)' %
+              (key(r) + (before, r['cycles'], change)))
+        failed = 1
+if not failed:
+    print('    none')
+sys.exit(failed)
+PYEOF
+	exit $?
+fi